@@ -7,6 +7,7 @@
  */
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 
 #include <epicsThread.h>
 
@@ -44,6 +45,7 @@ asynAxisAxis::asynAxisAxis(class asynAxisController *pC, int axisNo)
   }
   pC->pAxes_[axisNo] = this;
   status_.status = 0;
+  memset(&settings_, 0, sizeof(settings_));
   profilePositions_       = NULL;
   profileReadbacks_       = NULL;
   profileFollowingErrors_ = NULL;
@@ -58,8 +60,31 @@ asynAxisAxis::asynAxisAxis(class asynAxisController *pC, int axisNo)
   wasMovingFlag_ = 0;
   disableFlag_ = 0;
   initialPollDone_ = 0;
+  polled_ = 0;
+  updateStatusRequested_ = 0;
   lastEndOfMoveTime_ = 0;
 
+  positionDeadband_ = 0.0;
+  minCallbackInterval_ = 0.0;
+  positionChanged_ = 0;
+  publishedPosition_ = 0.0;
+  publishedEncoderPosition_ = 0.0;
+  epicsTimeGetCurrent(&lastCallbackTime_);
+
+  moveSequence_ = 0;
+  moveSequenceReported_ = 0;
+  moveSequenceForced_ = 0;
+  moveSequenceSupported_ = 0;
+  rawStatusDone_ = 0;
+
+  memset(positionSamples_, 0, sizeof(positionSamples_));
+  memset(encoderPositionSamples_, 0, sizeof(encoderPositionSamples_));
+  commandedVelocity_ = 0.0;
+  latencyState_ = 0;
+  compoundMove_ = NULL;
+  backlashState_ = 0;
+  retryState_ = 0;
+
   // Create the asynUser, connect to this axis
   pasynUser_ = pasynManager->createAsynUser(NULL, NULL);
   pasynManager->connectDevice(pasynUser_, pC->portName, axisNo);
@@ -82,6 +107,102 @@ asynStatus asynAxisAxis::move(double position, int relative, double minVelocity,
 }
 
 
+/** Move the motor and take out the backlash, as one command of the record.
+  * Drivers for controllers that can queue two moves should reimplement this
+  * and send both at once. This base class method is a sequencer in the driver:
+  * it calls move() for the first part, holds back the done bit when the
+  * controller reports it and starts the approach from the next poll.
+  * The approach is not started after a stop, or if the first part ended on a
+  * limit switch or with a problem.
+  * \param[in] position  The absolute position to move to (if relative=0) or the relative distance to move 
+  * by (if relative=1). Units=steps.
+  * \param[in] relative  Flag indicating relative moves (1) or absolute moves (0).
+  * \param[in] minVelocity The base velocity of both parts. Units=steps/sec.
+  * \param[in] maxVelocity The slew velocity of the first part. Units=steps/sec.
+  * \param[in] acceleration The acceleration of the first part. Units=steps/sec/sec.
+  * \param[in] finalPosition The end of the approach, relative to position if relative=1. Units=steps.
+  * \param[in] finalVelocity The velocity of the approach. Units=steps/sec.
+  * \param[in] finalAcceleration The acceleration of the approach. Units=steps/sec/sec. */
+asynStatus asynAxisAxis::moveWithBacklash(double position, int relative, double minVelocity,
+                                          double maxVelocity, double acceleration,
+                                          double finalPosition, double finalVelocity,
+                                          double finalAcceleration)
+{
+  asynStatus status;
+
+  status = move(position, relative, minVelocity, maxVelocity, acceleration);
+  if (status) return status;
+  backlashState_ = 1;
+  backlashPosition_ = finalPosition;
+  backlashRelative_ = relative;
+  backlashMinVelocity_ = minVelocity;
+  backlashVelocity_ = finalVelocity;
+  backlashAccel_ = finalAcceleration;
+  return status;
+}
+
+
+/** Start an absolute or relative move of writeFloat64().
+  * A MOTOR_MOVE_COMPOUND with MOTOR_COMPOUND_BACKLASH is started with moveWithBacklash(),
+  * anything else with move().
+  * With MOTOR_COMPOUND_RETRY the driver does the retries of the record: when the move is done
+  * and the error is not within the deadband, the done bit is held back and a relative
+  * correction of the fraction of the error is started from the next poll, up to the
+  * count of corrections.
+  * \param[in] position  The absolute position to move to (if relative=0) or the relative distance to move 
+  * by (if relative=1). Units=steps.
+  * \param[in] relative  Flag indicating relative move (1) or absolute move (0).
+  * \param[in] minVelocity The initial velocity, often called the base velocity. Units=steps/sec.
+  * \param[in] maxVelocity The maximum velocity, often called the slew velocity. Units=steps/sec.
+  * \param[in] acceleration The acceleration value. Units=steps/sec/sec. */
+asynStatus asynAxisAxis::startMove(double position, int relative, double minVelocity,
+                                   double maxVelocity, double acceleration)
+{
+  const MotorMoveCompound *pMove = compoundMove_;
+  int backlash = pMove && (pMove->mask & MOTOR_COMPOUND_BACKLASH);
+  int retry = pMove && (pMove->mask & MOTOR_COMPOUND_RETRY);
+  asynStatus status;
+
+  retryState_ = 0;
+  if (retry) {
+    /* The end of the move, in readback units */
+    retryTarget_ = backlash ? pMove->backlashValue : position;
+    if (relative) {
+      if (backlash) retryTarget_ += position;
+      retryTarget_ += retryReadback();
+    }
+    retryDeadband_ = pMove->retryDeadband;
+    retriesLeft_ = pMove->retryCount;
+    retryFraction_ = (pMove->retryFraction > 0.0) ? pMove->retryFraction : 1.0;
+    retryUseEncoder_ = pMove->retryUseEncoder;
+    retryMinVelocity_ = minVelocity;
+    retryVelocity_ = backlash ? pMove->backlashVelocity : maxVelocity;
+    retryAccel_ = backlash ? pMove->backlashAccel : acceleration;
+  }
+  if (backlash)
+    status = moveWithBacklash(position, relative, minVelocity, maxVelocity, acceleration,
+                              pMove->backlashValue, pMove->backlashVelocity,
+                              pMove->backlashAccel);
+  else
+    status = move(position, relative, minVelocity, maxVelocity, acceleration);
+  if (!status && retry) retryState_ = 1;
+  return status;
+}
+
+
+/** Change the target of the move in progress, without stopping.
+  * Drivers for controllers that can do this reimplement it and set
+  * motorFlagsRetarget_, which lets the record send new targets while moving.
+  * The move keeps its velocity and acceleration.
+  * This base class method returns asynError, and asynAxisController starts
+  * a move to the position instead.
+  * \param[in] position  The new absolute position to move to. Units=steps. */
+asynStatus asynAxisAxis::retarget(double position)
+{
+  return asynError;
+}
+
+
 /** Move the motor at a fixed velocity until told to stop.
   * \param[in] minVelocity The initial velocity, often called the base velocity. Units=steps/sec.
   * \param[in] maxVelocity The maximum velocity, often called the slew velocity. Units=steps/sec.
@@ -112,6 +233,19 @@ asynStatus asynAxisAxis::stop(double acceleration)
 }
 
 
+/** Stop the motor without waiting for the port lock.
+  * Called from the thread that processes the record, before the stop is queued.
+  * Drivers that can send a stop on a channel of its own, while the poller
+  * holds the port lock, implement this. It must not use the parameter library.
+  * The queued stop() is still called afterwards.
+  * \param[in] acceleration The acceleration value. Units=steps/sec/sec.
+  * \return asynSuccess if the stop was sent, the base class returns asynError */
+asynStatus asynAxisAxis::fastStop(double acceleration)
+{
+  return asynError;
+}
+
+
 /** initial poll of the axis.
   * This function is only called once and should read the configuration of the controller,
   * soft limits and other variables that can be used to initiate the record. */
@@ -240,6 +374,235 @@ void  asynAxisAxis::setReferencingModeMove(int distance)
 }
 
 
+/**
+ * Set the deadband for position-only status callbacks.
+ * A change of motorPosition_ or motorEncoderPosition_ only triggers a callback
+ * to devMotorAsyn when it differs by more than deadband from the value
+ * of the latest callback. When minCallbackInterval is > 0, position-only
+ * callbacks are additionally delayed until that many seconds have passed since
+ * the latest callback.  Changes of the status bits, flags or the read only
+ * configuration are always passed through immediately, together with the
+ * latest positions.
+ * \param[in] deadband Deadband in steps, 0 means every change is reported
+ * \param[in] minCallbackInterval Minimum time in seconds, 0 means no limit
+ */
+void asynAxisAxis::setPositionDeadband(double deadband, double minCallbackInterval)
+{
+  positionDeadband_ = deadband > 0.0 ? deadband : 0.0;
+  minCallbackInterval_ = minCallbackInterval > 0.0 ? minCallbackInterval : 0.0;
+}
+
+
+/**
+ * Start a new move sequence.
+ * Called by asynAxisController before each motion command is sent to the driver,
+ * so that the driver can tag the command with getMoveSequence().
+ */
+void asynAxisAxis::newMoveSequence(void)
+{
+  moveSequence_++;
+  /* A new command replaces the approach of moveWithBacklash()
+     and the retries of startMove() */
+  backlashState_ = 0;
+  retryState_ = 0;
+}
+
+
+/**
+ * Accept done for the latest move sequence, even if the controller
+ * never reports it. Used after a stop, or when the motion command failed.
+ */
+void asynAxisAxis::forceMoveSequenceDone(void)
+{
+  moveSequenceForced_ = moveSequence_;
+  backlashState_ = 0;
+  retryState_ = 0;
+}
+
+
+/**
+ * Start the approach of moveWithBacklash(), once the first part is done.
+ * Called by the poller with the port lock.
+ * \return 1 if the approach was started, 0 if the move ends here.
+ */
+int asynAxisAxis::startBacklashMove(void)
+{
+  asynStatus status;
+  int retryState = retryState_;
+  static const char *functionName = "startBacklashMove";
+
+  backlashState_ = 0;
+  if (status_.status & (STATUS_BIT_HIGH_LIMIT | STATUS_BIT_LOW_LIMIT | STATUS_BIT_PROBLEM)) {
+    /* Give the held back done bit to the record */
+    retryState_ = 0;
+    setIntegerParam(pC_->motorStatusDone_, rawStatusDone_);
+    callParamCallbacks();
+    return 0;
+  }
+  /* The retries follow the approach */
+  newMoveSequence();
+  retryState_ = retryState;
+  commandedVelocity_ = backlashVelocity_;
+  status = move(backlashPosition_, backlashRelative_, backlashMinVelocity_,
+                backlashVelocity_, backlashAccel_);
+  asynPrint(pasynUser_, ASYN_TRACE_FLOW,
+    "%s:%s: axis %d approach to %f, relative=%d, velocity=%f, acceleration=%f, status=%d\n",
+    driverName, functionName, axisNo_, backlashPosition_, backlashRelative_,
+    backlashVelocity_, backlashAccel_, (int)status);
+  if (status) {
+    forceMoveSequenceDone();
+    setIntegerParam(pC_->motorStatusDone_, rawStatusDone_);
+    callParamCallbacks();
+    return 0;
+  }
+  waitNumPollsBeforeReady_ = defWaitNumPollsBeforeReady_;
+  return 1;
+}
+
+
+/**
+ * The readback the retries of startMove() compare with their target, in steps.
+ */
+double asynAxisAxis::retryReadback(void)
+{
+  double ratio = 1.0;
+
+  if (!retryUseEncoder_) return positionSamples_[1].value;
+  pC_->getDoubleParam(axisNo_, pC_->motorEncoderRatio_, &ratio);
+  if (ratio == 0.0) ratio = 1.0;
+  return encoderPositionSamples_[1].value / fabs(ratio);
+}
+
+
+/**
+ * Check the error of a move with retries in the driver, once it is done,
+ * and start a correction if it is not within the deadband.
+ * Called by the poller with the port lock.
+ * \return 1 if a correction was started, 0 if the move ends here.
+ */
+int asynAxisAxis::startRetryMove(void)
+{
+  asynStatus status;
+  double error;
+  static const char *functionName = "startRetryMove";
+
+  retryState_ = 0;
+  error = retryTarget_ - retryReadback();
+  if (!(status_.status & (STATUS_BIT_HIGH_LIMIT | STATUS_BIT_LOW_LIMIT | STATUS_BIT_PROBLEM)) &&
+      (fabs(error) >= retryDeadband_) && (retriesLeft_ > 0)) {
+    retriesLeft_--;
+    newMoveSequence();
+    commandedVelocity_ = retryVelocity_;
+    status = move(retryFraction_ * error, 1, retryMinVelocity_, retryVelocity_, retryAccel_);
+    asynPrint(pasynUser_, ASYN_TRACE_FLOW,
+      "%s:%s: axis %d error %f, correction %f, %d left, status=%d\n",
+      driverName, functionName, axisNo_, error, retryFraction_ * error,
+      retriesLeft_, (int)status);
+    if (!status) {
+      retryState_ = 1;
+      waitNumPollsBeforeReady_ = defWaitNumPollsBeforeReady_;
+      return 1;
+    }
+    forceMoveSequenceDone();
+  }
+  /* In position, out of retries or stopped: give the held back done bit to the record */
+  setIntegerParam(pC_->motorStatusDone_, rawStatusDone_);
+  callParamCallbacks();
+  return 0;
+}
+
+
+/**
+ * Check if a done bit from the controller belongs to the latest move sequence.
+ */
+int asynAxisAxis::isMoveSequenceDone(void)
+{
+  if (!moveSequenceSupported_) return 1;
+  return (moveSequenceReported_ == moveSequence_) ||
+         (moveSequenceForced_ == moveSequence_);
+}
+
+
+/**
+ * Get the sequence number of the latest motion command.
+ * Drivers for controllers that accept a move ID can send it with the
+ * move command and report the echoed ID with setMoveSequenceReported().
+ */
+epicsUInt32 asynAxisAxis::getMoveSequence(void)
+{
+  return moveSequence_;
+}
+
+
+/**
+ * Report the move sequence the status of the controller belongs to.
+ * Either the ID echoed by the controller, or derived from a controller-side
+ * move counter: remember the counter when the move is commanded, and report
+ * getMoveSequence() once the counter has advanced.
+ * Once a driver has called this function, a done bit from the controller is
+ * only accepted when the reported sequence is the one of the latest
+ * motion command. This replaces waitNumPollsBeforeReady_ for those drivers.
+ * \param[in] sequence The sequence number reported by the controller.
+ */
+void asynAxisAxis::setMoveSequenceReported(epicsUInt32 sequence)
+{
+  moveSequenceSupported_ = 1;
+  moveSequenceReported_ = sequence;
+  /* The done bit may have been set before the sequence in this poll */
+  if (rawStatusDone_ && isMoveSequenceDone()) {
+    setIntegerParam(pC_->motorStatusDone_, rawStatusDone_);
+  }
+}
+
+
+/**
+ * Latency trace: the motion command has returned.
+ * Called by asynAxisController with the port lock, while the trace is on.
+ */
+void asynAxisAxis::traceMoveReturn(void)
+{
+  double latency;
+
+  epicsTimeGetCurrent(&latencyMoveTime_);
+  latency = epicsTimeDiffInSeconds(&latencyMoveTime_, &latencyCommandTime_);
+  pC_->addLatency(MOTOR_LATENCY_COMMAND, latency);
+  setDoubleParam(pC_->motorLatencyCommand_, latency);
+  latencyState_ = 1;
+}
+
+
+/**
+ * Latency trace: the poller has polled the axis of a traced move.
+ * A move that is done before any poll sees it moving counts the same
+ * time for the start and the done stage.
+ * \param[in] moving The axis is moving, as returned by poll().
+ */
+void asynAxisAxis::traceMovePoll(bool moving)
+{
+  epicsTimeStamp now;
+  double latency;
+
+  epicsTimeGetCurrent(&now);
+  latency = epicsTimeDiffInSeconds(&now, &latencyMoveTime_);
+  if (moving) {
+    if (latencyState_ != 1) return;
+    pC_->addLatency(MOTOR_LATENCY_START, latency);
+    setDoubleParam(pC_->motorLatencyStart_, latency);
+    latencyState_ = 2;
+  } else {
+    if (!(status_.status & STATUS_BIT_DONE)) return;
+    if (latencyState_ == 1) {
+      pC_->addLatency(MOTOR_LATENCY_START, latency);
+      setDoubleParam(pC_->motorLatencyStart_, latency);
+    }
+    pC_->addLatency(MOTOR_LATENCY_DONE, latency);
+    setDoubleParam(pC_->motorLatencyDone_, latency);
+    latencyState_ = 0;
+  }
+  callParamCallbacks();
+}
+
+
 /**
  * Get method for referencingModeMove_
  */
@@ -251,6 +614,36 @@ int  asynAxisAxis::getReferencingModeMove()
 
 
 
+/** Mirrors a parameter into settings_ if it is one of the cached motion settings.
+  * Called by asynAxisController::setIntegerParam() and asynAxisController::setDoubleParam()
+  * for every write to the parameter list of this axis, so that settings_ also follows
+  * writes that don't go through the setXXXParam methods of this class.
+  * \param[in] function The function (parameter) number
+  * \param[in] value Value that was set */
+void asynAxisAxis::updateSettings(int function, double value)
+{
+  if (function == pC_->motorVelocity_) {
+    settings_.velocity = value;
+  } else if (function == pC_->motorVelBase_) {
+    settings_.velBase = value;
+  } else if (function == pC_->motorAccel_) {
+    settings_.accel = value;
+  } else if (function == pC_->motorPowerAutoOnOff_) {
+    settings_.powerAutoOnOff = (int)value;
+  } else if (function == pC_->motorPowerOnDelay_) {
+    settings_.powerOnDelay = value;
+  } else if (function == pC_->motorPowerOffDelay_) {
+    settings_.powerOffDelay = value;
+  } else if (function == pC_->motorRecResolution_) {
+    settings_.recResolution = value;
+  } else if (function == pC_->motorRecOffset_) {
+    settings_.recOffset = value;
+  } else if (function == pC_->motorRecDirection_) {
+    settings_.recDirection = (int)value;
+  }
+}
+
+
 // We implement the setIntegerParam, setDoubleParam, and callParamCallbacks methods so we can construct 
 // the aggregate status structure and do callbacks on it
 
@@ -259,6 +652,8 @@ int  asynAxisAxis::getReferencingModeMove()
   * (motorStatusDirection_, motorStatusHomed_, etc.).  In that case it sets or clears the appropriate
   * bit in its private MotorStatus.status structure and if that status has changed sets a flag to
   * do callbacks to devMotorAsyn when callParamCallbacks() is called.
+  * A done bit is only accepted, if it belongs to the latest move sequence,
+  * see setMoveSequenceReported().
   * \param[in] function The function (parameter) number 
   * \param[in] value Value to set */
 asynStatus asynAxisAxis::setIntegerParam(int function, int value)
@@ -268,9 +663,17 @@ asynStatus asynAxisAxis::setIntegerParam(int function, int value)
   // This assumes the parameters defined above are in the same order as the bits the motor record expects!
   if (function >= pC_->motorStatusDirection_ && 
       function <= pC_->motorStatusHomed_) {
+    if (function == pC_->motorStatusDone_) {
+      rawStatusDone_ = value;
+      if (value && !isMoveSequenceDone()) {
+        /* Done for an earlier move, the latest one has not started yet */
+        value = 0;
+      }
+    }
     if ((function == pC_->motorStatusDone_) &&
-        waitNumPollsBeforeReady_) {
-      /* Work around the ready before started problem */
+        waitNumPollsBeforeReady_ && !moveSequenceSupported_) {
+      /* Work around the ready before started problem,
+         for drivers that don't report a move sequence */
       if (value) {
         waitNumPollsBeforeReady_--;
         value = 0;
@@ -279,6 +682,15 @@ asynStatus asynAxisAxis::setIntegerParam(int function, int value)
       }
       statusChanged_ = 1;
     }
+    if ((function == pC_->motorStatusDone_) && value && backlashState_) {
+      /* The first part of moveWithBacklash() is done, the approach follows */
+      backlashState_ = 2;
+      value = 0;
+    } else if ((function == pC_->motorStatusDone_) && value && retryState_) {
+      /* The move is done, check the error before the record sees done */
+      retryState_ = 2;
+      value = 0;
+    }
 
     status = status_.status;
     mask = 1 << (function - pC_->motorStatusDirection_);
@@ -288,10 +700,14 @@ asynStatus asynAxisAxis::setIntegerParam(int function, int value)
       status_.status = status;
       statusChanged_ = 1;
     }
-  } else  if (function >= pC_->motorFlagsHomeOnLs_ && 
-              function <= pC_->motorFlagsStopOnProblem_) {
+  } else  if ((function >= pC_->motorFlagsHomeOnLs_ && 
+               function <= pC_->motorFlagsStopOnProblem_) ||
+              function == pC_->motorFlagsRetarget_) {
     flags = status_.flags;
-    mask = 1 << (function - pC_->motorFlagsHomeOnLs_);
+    if (function == pC_->motorFlagsRetarget_)
+      mask = 1 << 3; /* MF_RETARGET */
+    else
+      mask = 1 << (function - pC_->motorFlagsHomeOnLs_);
     if (value) flags |= mask;
     else       flags &= ~mask;
     if (flags != status_.flags) {
@@ -309,20 +725,30 @@ asynStatus asynAxisAxis::setIntegerParam(int function, int value)
 /** Sets the value for a double for this axis in the parameter library.
   * This function takes special action if the parameter is motorPosition_ or motorEncoderPosition_.  
   * In that case it sets the value in the private MotorStatus structure and if the value has changed
-  * then sets a flag to do callbacks to devMotorAsyn when callParamCallbacks() is called.
+  * by more than positionDeadband_ since the latest callback, sets a flag to do callbacks
+  * to devMotorAsyn when callParamCallbacks() is called.
   * \param[in] function The function (parameter) number 
   * \param[in] value Value to set */
 asynStatus asynAxisAxis::setDoubleParam(int function, double value)
 {
   if (function == pC_->motorPosition_) {
+    addPositionSample(positionSamples_, value);
+    if (status_.status & STATUS_BIT_ESTIMATED) {
+      /* A real poll corrects the estimated positions */
+      status_.status &= ~STATUS_BIT_ESTIMATED;
+      statusChanged_ = 1;
+    }
     if (value != status_.position) {
-        statusChanged_ = 1;
         status_.position = value;
+        if (fabs(value - publishedPosition_) > positionDeadband_)
+          positionChanged_ = 1;
     }
   } else if (function == pC_->motorEncoderPosition_) {
+    addPositionSample(encoderPositionSamples_, value);
     if (value != status_.encoderPosition) {
-        statusChanged_ = 1;
         status_.encoderPosition = value;
+        if (fabs(value - publishedEncoderPosition_) > positionDeadband_)
+          positionChanged_ = 1;
     }
   } else if (function == pC_->motorHighLimitRO_) {
     if (value != status_.MotorConfigRO.motorHighLimitRaw) {
@@ -531,17 +957,85 @@ void asynAxisAxis::updateMsgTxtField()
 
 /** Calls the callbacks for any parameters that have changed for this axis in the parameter library.
   * This function takes special action if the aggregate MotorStatus structure has changed.
-  * In that case it does callbacks on the asynGenericPointer interface, typically to devMotorAsyn. */  
+  * In that case it does callbacks on the asynGenericPointer interface, typically to devMotorAsyn.
+  * A change of the positions alone is held back until minCallbackInterval_ has expired. */  
 asynStatus asynAxisAxis::callParamCallbacks()
 {
+  epicsTimeStamp now;
+
+  if (positionChanged_ && !statusChanged_) {
+    if (minCallbackInterval_ > 0.0) {
+      epicsTimeGetCurrent(&now);
+      if (epicsTimeDiffInSeconds(&now, &lastCallbackTime_) >= minCallbackInterval_)
+        statusChanged_ = 1;
+    } else {
+      statusChanged_ = 1;
+    }
+  }
   if (statusChanged_) {
     statusChanged_ = 0;
+    positionChanged_ = 0;
+    publishedPosition_ = status_.position;
+    publishedEncoderPosition_ = status_.encoderPosition;
+    epicsTimeGetCurrent(&lastCallbackTime_);
     updateMsgTxtField();
     pC_->doCallbacksGenericPointer((void *)&status_, pC_->motorStatus_, axisNo_);
   }
   return pC_->callParamCallbacks(axisNo_);
 }
 
+/** Keep the last two polled positions together with the time they were polled.
+  * \param[in,out] samples Array of 2 samples, [1] is the latest
+  * \param[in] value The polled position */
+void asynAxisAxis::addPositionSample(PositionSample *samples, double value)
+{
+  samples[0] = samples[1];
+  epicsTimeGetCurrent(&samples[1].time);
+  samples[1].value = value;
+}
+
+/** Extrapolate a position from the last two samples.
+  * The velocity is taken from the samples and limited to the commanded velocity.
+  * \param[in] samples Array of 2 samples, [1] is the latest
+  * \param[in] now The current time
+  * \param[in] maxAge Don't extrapolate further than this (seconds) after the latest sample */
+double asynAxisAxis::extrapolatePosition(const PositionSample *samples,
+                                         const epicsTimeStamp *now, double maxAge)
+{
+  double sampleDelta = epicsTimeDiffInSeconds(&samples[1].time, &samples[0].time);
+  double age = epicsTimeDiffInSeconds(now, &samples[1].time);
+  double velocity;
+  double maxVelocity = fabs(commandedVelocity_);
+
+  if (sampleDelta <= 0.0) return samples[1].value;
+  velocity = (samples[1].value - samples[0].value) / sampleDelta;
+  if (maxVelocity > 0.0) {
+    if (velocity > maxVelocity) velocity = maxVelocity;
+    else if (velocity < -maxVelocity) velocity = -maxVelocity;
+  }
+  if (age > maxAge) age = maxAge;
+  if (age < 0.0) age = 0.0;
+  return samples[1].value + velocity * age;
+}
+
+/** Publish extrapolated positions between two polls of a moving axis.
+  * Called by the poller of asynAxisController when setEstimatePeriod() is in use.
+  * The values are only passed to devMotorAsyn, flagged with STATUS_BIT_ESTIMATED;
+  * the parameter library keeps the polled values, and the next poll corrects them.
+  * \param[in] maxAge Don't extrapolate further than this (seconds) after the latest poll */
+void asynAxisAxis::publishEstimatedPosition(double maxAge)
+{
+  epicsTimeStamp now;
+
+  if (!initialPollDone_ || (status_.status & STATUS_BIT_DONE)) return;
+  epicsTimeGetCurrent(&now);
+  status_.position = extrapolatePosition(positionSamples_, &now, maxAge);
+  if (status_.status & STATUS_BIT_HAS_ENCODER)
+    status_.encoderPosition = extrapolatePosition(encoderPositionSamples_, &now, maxAge);
+  status_.status |= STATUS_BIT_ESTIMATED;
+  pC_->doCallbacksGenericPointer((void *)&status_, pC_->motorStatus_, axisNo_);
+}
+
 /* These are the functions for profile moves */
 asynStatus asynAxisAxis::initializeProfile(size_t maxProfilePoints)
 {
@@ -566,11 +1060,10 @@ asynStatus asynAxisAxis::initializeProfile(size_t maxProfilePoints)
 asynStatus asynAxisAxis::defineProfile(double *positions, size_t numPoints)
 {
   size_t i;
-  double resolution;
-  double offset;
-  int direction;
+  double resolution = settings_.recResolution;
+  double offset = settings_.recOffset;
+  int direction = settings_.recDirection;
   double scale;
-  int status=0;
   static const char *functionName = "defineProfile";
   
   asynPrint(pasynUser_, ASYN_TRACE_FLOW,
@@ -579,13 +1072,9 @@ asynStatus asynAxisAxis::defineProfile(double *positions, size_t numPoints)
 
   if (numPoints > pC_->maxProfilePoints_) return asynError;
 
-  status |= pC_->getDoubleParam(axisNo_, pC_->motorRecResolution_, &resolution);
-  status |= pC_->getDoubleParam(axisNo_, pC_->motorRecOffset_, &offset);
-  status |= pC_->getIntegerParam(axisNo_, pC_->motorRecDirection_, &direction);
   asynPrint(pasynUser_, ASYN_TRACE_FLOW,
-            "%s:%s: axis=%d, status=%d, offset=%f direction=%d, resolution=%f\n",
-            driverName, functionName, axisNo_, status, offset, direction, resolution);
-  if (status) return asynError;
+            "%s:%s: axis=%d, offset=%f direction=%d, resolution=%f\n",
+            driverName, functionName, axisNo_, offset, direction, resolution);
   if (resolution == 0.0) return asynError;
   
   // Convert to controller units
@@ -641,16 +1130,13 @@ asynStatus asynAxisAxis::abortProfile()
 asynStatus asynAxisAxis::readbackProfile()
 {
   int i;
-  double resolution;
-  double offset;
-  int direction;
+  double resolution = settings_.recResolution;
+  double offset = settings_.recOffset;
+  int direction = settings_.recDirection;
   int numReadbacks;
   int status=0;
   //static const char *functionName = "readbackProfile";
 
-  status |= pC_->getDoubleParam(axisNo_, pC_->motorRecResolution_, &resolution);
-  status |= pC_->getDoubleParam(axisNo_, pC_->motorRecOffset_, &offset);
-  status |= pC_->getIntegerParam(axisNo_, pC_->motorRecDirection_, &direction);
   status |= pC_->getIntegerParam(0, pC_->profileNumReadbacks_, &numReadbacks);
   if (status) return asynError;
   
@@ -10,12 +10,30 @@
 
 #include <epicsEvent.h>
 #include <epicsTypes.h>
+#include <epicsTime.h>
 
 #ifdef __cplusplus
 #include <asynPortDriver.h>
 
 #include "asynAxisController.h"
 
+/** Per-axis copy of the motion settings that are needed on every command
+  * and on every poll cycle. It is updated by asynAxisController::setDoubleParam()
+  * and asynAxisController::setIntegerParam() whenever one of the corresponding
+  * parameters is written for the axis, so that the hot paths don't need to look them up
+  * in the parameter library. */
+typedef struct MotorAxisSettings {
+  double velocity;           /**< MOTOR_VELOCITY, steps/sec */
+  double velBase;            /**< MOTOR_VEL_BASE, steps/sec */
+  double accel;              /**< MOTOR_ACCEL, steps/sec/sec */
+  int    powerAutoOnOff;     /**< MOTOR_POWER_AUTO_ONOFF */
+  double powerOnDelay;       /**< MOTOR_POWER_ON_DELAY, sec */
+  double powerOffDelay;      /**< MOTOR_POWER_OFF_DELAY, sec */
+  double recResolution;      /**< MOTOR_REC_RESOLUTION */
+  double recOffset;          /**< MOTOR_REC_OFFSET */
+  int    recDirection;       /**< MOTOR_REC_DIRECTION */
+} MotorAxisSettings;
+
 /** Class from which motor axis objects are derived. */
 class epicsShareClass asynAxisAxis {
 
@@ -31,9 +49,16 @@ class epicsShareClass asynAxisAxis {
   virtual asynStatus callParamCallbacks();
 
   virtual asynStatus move(double position, int relative, double minVelocity, double maxVelocity, double acceleration);
+  virtual asynStatus moveWithBacklash(double position, int relative, double minVelocity, double maxVelocity,
+                                      double acceleration, double finalPosition, double finalVelocity,
+                                      double finalAcceleration);
+  asynStatus startMove(double position, int relative, double minVelocity, double maxVelocity,
+                       double acceleration);
+  virtual asynStatus retarget(double position);
   virtual asynStatus moveVelocity(double minVelocity, double maxVelocity, double acceleration);
   virtual asynStatus home(double minVelocity, double maxVelocity, double acceleration, int forwards);
   virtual asynStatus stop(double acceleration);
+  virtual asynStatus fastStop(double acceleration);
   virtual asynStatus initialPoll(void);
   virtual void       handleDisconnect(asynStatus);
   virtual asynStatus poll(bool *moving);
@@ -65,6 +90,9 @@ class epicsShareClass asynAxisAxis {
   double getLastEndOfMoveTime();
   void setLastEndOfMoveTime(double time);
   void updateMsgTxtFromDriver(const char *value);
+  void setPositionDeadband(double deadband, double minCallbackInterval);
+  epicsUInt32 getMoveSequence();
+  void setMoveSequenceReported(epicsUInt32 sequence);
 
   protected:
   class asynAxisController *pC_;    /**< Pointer to the asynAxisController to which this axis belongs.
@@ -76,13 +104,65 @@ class epicsShareClass asynAxisAxis {
   double *profileFollowingErrors_;   /**< Array of following errors for profile moves */   
   int referencingMode_;
   MotorStatus status_;
+  MotorAxisSettings settings_;
+  void updateSettings(int function, double value);
   int statusChanged_;
   int waitNumPollsBeforeReady_;
   int defWaitNumPollsBeforeReady_;
   int initialPollDone_;
+  int polled_;                       /**< The axis was polled since the IOC started */
+  int updateStatusRequested_;        /**< MOTOR_UPDATE_STATUS waits for the next poll */
   
   private:
   void updateMsgTxtField(void);
+  double positionDeadband_;           /**< Raw position change needed to trigger a status callback */
+  double minCallbackInterval_;        /**< Minimum time between position-only status callbacks */
+  int positionChanged_;               /**< Position moved by more than positionDeadband_ */
+  double publishedPosition_;          /**< Position in the latest status callback */
+  double publishedEncoderPosition_;   /**< Encoder position in the latest status callback */
+  epicsTimeStamp lastCallbackTime_;   /**< Time of the latest status callback */
+  void newMoveSequence(void);
+  void forceMoveSequenceDone(void);
+  int isMoveSequenceDone(void);
+  epicsUInt32 moveSequence_;          /**< Sequence number of the latest motion command */
+  epicsUInt32 moveSequenceReported_;  /**< Sequence number the controller status belongs to */
+  epicsUInt32 moveSequenceForced_;    /**< Sequence number that was stopped or failed */
+  int moveSequenceSupported_;         /**< The driver reports sequence numbers */
+  int rawStatusDone_;                 /**< Done bit as reported by the driver */
+  typedef struct PositionSample {
+    epicsTimeStamp time;
+    double value;
+  } PositionSample;
+  void addPositionSample(PositionSample *samples, double value);
+  double extrapolatePosition(const PositionSample *samples, const epicsTimeStamp *now, double maxAge);
+  void publishEstimatedPosition(double maxAge);
+  PositionSample positionSamples_[2];        /**< The last two polled positions, [1] is the latest */
+  PositionSample encoderPositionSamples_[2]; /**< The last two polled encoder positions */
+  double commandedVelocity_;          /**< Velocity of the latest motion command */
+  void traceMoveReturn(void);
+  void traceMovePoll(bool moving);
+  int latencyState_;                  /**< 0 = no traced move, 1 = waiting for moving, 2 = for done */
+  epicsTimeStamp latencyCommandTime_; /**< Entry of writeFloat64() */
+  epicsTimeStamp latencyMoveTime_;    /**< Return of move() */
+  int startBacklashMove(void);
+  const MotorMoveCompound *compoundMove_; /**< MOTOR_MOVE_COMPOUND of the current writeFloat64() */
+  int backlashState_;                 /**< 0 = no approach, 1 = first part moving, 2 = approach to start */
+  double backlashPosition_;           /**< Parameters of the approach, see moveWithBacklash() */
+  int backlashRelative_;
+  double backlashMinVelocity_;
+  double backlashVelocity_;
+  double backlashAccel_;
+  int startRetryMove(void);
+  double retryReadback(void);
+  int retryState_;                    /**< 0 = no retries, 1 = move or correction moving, 2 = check the error */
+  double retryTarget_;                /**< Parameters of the retries, see startMove() */
+  double retryDeadband_;
+  int retriesLeft_;
+  double retryFraction_;
+  int retryUseEncoder_;
+  double retryMinVelocity_;
+  double retryVelocity_;
+  double retryAccel_;
   int referencingModeMove_;
   int wasMovingFlag_;
   int disableFlag_;
@@ -9,6 +9,9 @@
 #include <string.h>
 
 #include <epicsThread.h>
+#include <epicsStdio.h>
+#include <epicsString.h>
+#include <epicsAtomic.h>
 #include <iocsh.h>
 
 #include <asynPortDriver.h>
@@ -20,6 +23,9 @@
 #include "asynAxisAxis.h"
 
 static const char *driverName = "asynAxisController";
+/* Upper limits of the bins of the latency trace histograms in seconds, the last bin takes the rest */
+static const double latencyLimits[MOTOR_LATENCY_BINS-1] = {1e-4, 1e-3, 1e-2, 1e-1, 1., 10., 100.};
+static const char * const latencyStageNames[MOTOR_LATENCY_STAGES] = {"command", "start", "done"};
 static void asynMotorPollerC(void *drvPvt);
 static void asynMotorMoveToHomeC(void *drvPvt);
 
@@ -38,7 +44,9 @@ asynAxisController::asynAxisController(const char *portName, int numAxes, int nu
       interfaceMask | asynOctetMask | asynInt32Mask | asynFloat64Mask | asynFloat64ArrayMask | asynGenericPointerMask | asynDrvUserMask,
       interruptMask | asynOctetMask | asynInt32Mask | asynFloat64Mask | asynFloat64ArrayMask | asynGenericPointerMask,
       asynFlags, autoConnect, priority, stackSize),
-    shuttingDown_(0), numAxes_(numAxes)
+    shuttingDown_(0), numAxes_(numAxes), stopsPending_(0), pollerStarted_(0), latencyTrace_(0),
+    controllerParamsCreated_(0),
+    paramNames_(NULL), numParamNames_(0)
 
 {
   static const char *functionName = "asynAxisController";
@@ -73,6 +81,12 @@ asynAxisController::asynAxisController(const char *portName, int numAxes, int nu
   createParam(motorLatestCommandString,          asynParamInt32,      &motorLatestCommand_);
   createParam(motorMessageIsFromDriverString,    asynParamInt32,      &motorMessageIsFromDriver_);
   createParam(motorMessageTextString,            asynParamOctet,      &motorMessageText_);
+  createParam(motorMoveCompoundString,           asynParamGenericPointer, &motorMoveCompound_);
+  createParam(motorLatencyTraceString,           asynParamInt32,      &motorLatencyTrace_);
+  createParam(motorLatencyCommandString,         asynParamFloat64,    &motorLatencyCommand_);
+  createParam(motorLatencyStartString,           asynParamFloat64,    &motorLatencyStart_);
+  createParam(motorLatencyDoneString,            asynParamFloat64,    &motorLatencyDone_);
+  createParam(motorRetargetString,               asynParamFloat64,    &motorRetarget_);
   createParam(motorStatusDirectionString,        asynParamInt32,      &motorStatusDirection_);
   createParam(motorStatusDoneString,             asynParamInt32,      &motorStatusDone_);
   createParam(motorStatusHighLimitString,        asynParamInt32,      &motorStatusHighLimit_);
@@ -92,6 +106,7 @@ asynAxisController::asynAxisController(const char *portName, int numAxes, int nu
   /* Addition flags which can be set by the specific driver */
   createParam(motorFlagsHomeOnLsString,          asynParamInt32,      &motorFlagsHomeOnLs_);
   createParam(motorFlagsStopOnProblemString,     asynParamInt32,      &motorFlagsStopOnProblem_);
+  createParam(motorFlagsRetargetString,          asynParamInt32,      &motorFlagsRetarget_);
 
   createParam(motorNotHomedProblemString,        asynParamInt32,      &motorNotHomedProblem_);
 
@@ -110,50 +125,32 @@ asynAxisController::asynAxisController(const char *portName, int numAxes, int nu
   createParam(motorSDBDROString,                 asynParamFloat64,    &motorSDBDRO_);
   createParam(motorRDBDROString,                 asynParamFloat64,    &motorRDBDRO_);
 
-  // These are the per-controller parameters for profile moves
-  createParam(profileNumAxesString,              asynParamInt32,      &profileNumAxes_);
-  createParam(profileNumPointsString,            asynParamInt32,      &profileNumPoints_);
-  createParam(profileCurrentPointString,         asynParamInt32,      &profileCurrentPoint_);
-  createParam(profileNumPulsesString,            asynParamInt32,      &profileNumPulses_);
-  createParam(profileStartPulsesString,          asynParamInt32,      &profileStartPulses_);
-  createParam(profileEndPulsesString,            asynParamInt32,      &profileEndPulses_);
-  createParam(profileActualPulsesString,         asynParamInt32,      &profileActualPulses_);
-  createParam(profileNumReadbacksString,         asynParamInt32,      &profileNumReadbacks_);
-  createParam(profileTimeModeString,             asynParamInt32,      &profileTimeMode_);
-  createParam(profileFixedTimeString,          asynParamFloat64,      &profileFixedTime_);
-  createParam(profileTimeArrayString,     asynParamFloat64Array,      &profileTimeArray_);
-  createParam(profileAccelerationString,       asynParamFloat64,      &profileAcceleration_);
-  createParam(profileMoveModeString,             asynParamInt32,      &profileMoveMode_);
-  createParam(profileBuildString,                asynParamInt32,      &profileBuild_);
-  createParam(profileBuildStateString,           asynParamInt32,      &profileBuildState_);
-  createParam(profileBuildStatusString,          asynParamInt32,      &profileBuildStatus_);
-  createParam(profileBuildMessageString,         asynParamOctet,      &profileBuildMessage_);
-  createParam(profileExecuteString,              asynParamInt32,      &profileExecute_);
-  createParam(profileExecuteStateString,         asynParamInt32,      &profileExecuteState_);
-  createParam(profileExecuteStatusString,        asynParamInt32,      &profileExecuteStatus_);
-  createParam(profileExecuteMessageString,       asynParamOctet,      &profileExecuteMessage_);
-  createParam(profileAbortString,                asynParamInt32,      &profileAbort_);
-  createParam(profileReadbackString,             asynParamInt32,      &profileReadback_);
-  createParam(profileReadbackStateString,        asynParamInt32,      &profileReadbackState_);
-  createParam(profileReadbackStatusString,       asynParamInt32,      &profileReadbackStatus_);
-  createParam(profileReadbackMessageString,      asynParamOctet,      &profileReadbackMessage_);
-
   // These are the per-axis parameters for profile moves
   createParam(profileUseAxisString,              asynParamInt32,      &profileUseAxis_);
   createParam(profilePositionsString,     asynParamFloat64Array,      &profilePositions_);
   createParam(profileReadbacksString,     asynParamFloat64Array,      &profileReadbacks_);
   createParam(profileFollowingErrorsString, asynParamFloat64Array,    &profileFollowingErrors_);
 
+  /* The per-controller parameters are only created in the parameter list
+   * of address 0, by createControllerParams() */
+  for (int i=0; i<NUM_MOTOR_CONTROLLER_PARAMS; i++) {
+    (&FIRST_MOTOR_CONTROLLER_PARAM)[i] = -1;
+  }
+
   pAxes_ = (asynAxisAxis**) calloc(numAxes, sizeof(asynAxisAxis*));
   pollEventId_ = epicsEventMustCreate(epicsEventEmpty);
   moveToHomeId_ = epicsEventMustCreate(epicsEventEmpty);
 
+  estimatePeriod_ = 0.0;
   maxProfilePoints_ = 0;
   profileTimes_ = NULL;
-  setIntegerParam(profileExecuteState_, PROFILE_EXECUTE_DONE);
   pasynUserController_ = NULL;
   asynStatusConnected_ = asynDisconnected;
   moveToHomeAxis_ = 0;
+  /* Controllers are created from the startup script, one at a time */
+  nextController_ = controllerList_;
+  controllerList_ = this;
+
   asynPrint(this->pasynUserSelf, ASYN_TRACE_FLOW,
     "%s:%s: constructor complete\n",
     driverName, functionName);
@@ -161,6 +158,144 @@ asynAxisController::asynAxisController(const char *portName, int numAxes, int nu
 
 asynAxisController::~asynAxisController()
 {
+  asynAxisController **ppC;
+
+  for (ppC = &controllerList_; *ppC; ppC = &(*ppC)->nextController_) {
+    if (*ppC == this) {
+      *ppC = nextController_;
+      break;
+    }
+  }
+  free(paramNames_);
+}
+
+asynAxisController *asynAxisController::controllerList_ = NULL;
+
+/** Finds the asynAxisController of a port.
+  * Unlike findAsynPortDriver() this only finds ports that are an asynAxisController,
+  * so the result can be used without knowing the driver of the port.
+  * \param[in] portName The name of the asyn port.
+  * \return The controller, or NULL if the port isn't an asynAxisController. */
+asynAxisController *asynAxisController::findController(const char *portName)
+{
+  asynAxisController *pC;
+
+  for (pC = controllerList_; pC; pC = pC->nextController_) {
+    if (!strcmp(pC->portName, portName)) return pC;
+  }
+  return NULL;
+}
+
+/** Creates the per-controller parameters (profile moves).
+  * These are only needed once per controller, so they are only created in the
+  * parameter list for address 0 and not in the lists of the other axes.
+  * The index of a parameter is its position in a list, so they must be the last
+  * parameters of the controller.
+  * Derived classes that support profile moves call this once in their constructor,
+  * after they have created their own parameters. Without it the indices of the
+  * per-controller parameters stay -1 and initializeProfile() fails. */
+void asynAxisController::createControllerParams()
+{
+  static const char *functionName = "createControllerParams";
+
+  if (controllerParamsCreated_) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: port=%s the controller parameters already exist\n",
+      driverName, functionName, portName);
+    return;
+  }
+  controllerParamsCreated_ = 1;
+
+  createParam(0, profileNumAxesString,           asynParamInt32,      &profileNumAxes_);
+  createParam(0, profileNumPointsString,         asynParamInt32,      &profileNumPoints_);
+  createParam(0, profileCurrentPointString,      asynParamInt32,      &profileCurrentPoint_);
+  createParam(0, profileNumPulsesString,         asynParamInt32,      &profileNumPulses_);
+  createParam(0, profileStartPulsesString,       asynParamInt32,      &profileStartPulses_);
+  createParam(0, profileEndPulsesString,         asynParamInt32,      &profileEndPulses_);
+  createParam(0, profileActualPulsesString,      asynParamInt32,      &profileActualPulses_);
+  createParam(0, profileNumReadbacksString,      asynParamInt32,      &profileNumReadbacks_);
+  createParam(0, profileTimeModeString,          asynParamInt32,      &profileTimeMode_);
+  createParam(0, profileFixedTimeString,       asynParamFloat64,      &profileFixedTime_);
+  createParam(0, profileTimeArrayString,  asynParamFloat64Array,      &profileTimeArray_);
+  createParam(0, profileAccelerationString,    asynParamFloat64,      &profileAcceleration_);
+  createParam(0, profileMoveModeString,          asynParamInt32,      &profileMoveMode_);
+  createParam(0, profileBuildString,             asynParamInt32,      &profileBuild_);
+  createParam(0, profileBuildStateString,        asynParamInt32,      &profileBuildState_);
+  createParam(0, profileBuildStatusString,       asynParamInt32,      &profileBuildStatus_);
+  createParam(0, profileBuildMessageString,      asynParamOctet,      &profileBuildMessage_);
+  createParam(0, profileExecuteString,           asynParamInt32,      &profileExecute_);
+  createParam(0, profileExecuteStateString,      asynParamInt32,      &profileExecuteState_);
+  createParam(0, profileExecuteStatusString,     asynParamInt32,      &profileExecuteStatus_);
+  createParam(0, profileExecuteMessageString,    asynParamOctet,      &profileExecuteMessage_);
+  createParam(0, profileAbortString,             asynParamInt32,      &profileAbort_);
+  createParam(0, profileReadbackString,          asynParamInt32,      &profileReadback_);
+  createParam(0, profileReadbackStateString,     asynParamInt32,      &profileReadbackState_);
+  createParam(0, profileReadbackStatusString,    asynParamInt32,      &profileReadbackStatus_);
+  createParam(0, profileReadbackMessageString,   asynParamOctet,      &profileReadbackMessage_);
+
+  setIntegerParam(profileExecuteState_, PROFILE_EXECUTE_DONE);
+}
+
+static int compareParamNames(const void *p1, const void *p2)
+{
+  return strcmp(((const MotorParamName *)p1)->name, ((const MotorParamName *)p2)->name);
+}
+
+/** Builds the sorted table of the motor parameter names used by drvUserCreate().
+  * Every record of every axis looks up the same strings, a binary search
+  * saves the linear search through the parameter list of the base class.
+  * The table only has the per-axis parameters, which exist in every list.
+  * The per-controller parameters only exist in the list of address 0,
+  * they are left to the base class, which rejects them for other addresses. */
+void asynAxisController::createParamNames()
+{
+  int *pIndex;
+  int n = 0;
+
+  paramNames_ = (MotorParamName *)calloc(NUM_MOTOR_DRIVER_PARAMS, sizeof(MotorParamName));
+  for (pIndex = &FIRST_MOTOR_PARAM; pIndex <= &LAST_MOTOR_PARAM; pIndex++) {
+    if ((pIndex >= &FIRST_MOTOR_CONTROLLER_PARAM) &&
+        (pIndex <= &LAST_MOTOR_CONTROLLER_PARAM)) continue;
+    if (getParamName(*pIndex, &paramNames_[n].name) != asynSuccess) continue;
+    paramNames_[n].index = *pIndex;
+    n++;
+  }
+  qsort(paramNames_, n, sizeof(MotorParamName), compareParamNames);
+  numParamNames_ = n;
+}
+
+/** Called when asyn clients call pasynDrvUser->create().
+  * Looks up the per-axis motor parameters in the sorted table. The per-controller
+  * parameters and the strings of derived classes are looked up by the base class.
+  * \param[in] pasynUser asynUser structure that encodes the reason and address.
+  * \param[in] drvInfo String containing information about what driver function is being referenced.
+  * \param[out] pptypeName Location in which driver puts a copy of drvInfo.
+  * \param[out] psize Location where driver puts size of param. */
+asynStatus asynAxisController::drvUserCreate(asynUser *pasynUser, const char *drvInfo,
+                                             const char **pptypeName, size_t *psize)
+{
+  MotorParamName key, *pName;
+  int addr;
+  asynStatus status;
+  static const char *functionName = "drvUserCreate";
+
+  if (!paramNames_) createParamNames();
+
+  key.name = drvInfo;
+  pName = (MotorParamName *)bsearch(&key, paramNames_, numParamNames_,
+                                    sizeof(MotorParamName), compareParamNames);
+  if (!pName)
+    return asynPortDriver::drvUserCreate(pasynUser, drvInfo, pptypeName, psize);
+
+  status = getAddress(pasynUser, &addr);
+  if (status != asynSuccess) return status;
+  pasynUser->reason = pName->index;
+  if (pptypeName) *pptypeName = epicsStrDup(drvInfo);
+  if (psize) *psize = sizeof(pName->index);
+  asynPrint(pasynUser, ASYN_TRACE_FLOW,
+    "%s:%s: drvInfo=%s, index=%d\n",
+    driverName, functionName, drvInfo, pName->index);
+  return asynSuccess;
 }
 
 /** Called when asyn clients call pasynManager->report().
@@ -172,6 +307,7 @@ void asynAxisController::report(FILE *fp, int level)
 {
   int axis;
   asynAxisAxis *pAxis;
+  int stage, i;
 
   for (axis=0; axis<numAxes_; axis++) {
     pAxis = getAxis(axis);
@@ -179,11 +315,46 @@ void asynAxisController::report(FILE *fp, int level)
     pAxis->report(fp, level);
   }
 
+  if (latencyTrace_) {
+    for (stage=0; stage<MOTOR_LATENCY_STAGES; stage++) {
+      fprintf(fp, "  latency %-7s", latencyStageNames[stage]);
+      for (i=0; i<MOTOR_LATENCY_BINS-1; i++)
+        fprintf(fp, " <%gs:%lu", latencyLimits[i], latencyHistogram_[stage][i]);
+      fprintf(fp, " more:%lu\n", latencyHistogram_[stage][i]);
+    }
+  }
+
   // Call the base class method
   asynPortDriver::report(fp, level);
 }
 
 
+/** Sets the value for an integer in the parameter library.
+  * Calls the base class method and keeps asynAxisAxis::settings_ of the axis
+  * in step with it, also for writes that bypass asynAxisAxis::setIntegerParam().
+  * \param[in] list The parameter list number, which is the axis number.
+  * \param[in] index The parameter number
+  * \param[in] value Value to set */
+asynStatus asynAxisController::setIntegerParam(int list, int index, int value)
+{
+  if ((list >= 0) && (list < numAxes_) && pAxes_[list])
+    pAxes_[list]->updateSettings(index, value);
+  return asynPortDriver::setIntegerParam(list, index, value);
+}
+
+/** Sets the value for a double in the parameter library.
+  * Calls the base class method and keeps asynAxisAxis::settings_ of the axis
+  * in step with it, also for writes that bypass asynAxisAxis::setDoubleParam().
+  * \param[in] list The parameter list number, which is the axis number.
+  * \param[in] index The parameter number
+  * \param[in] value Value to set */
+asynStatus asynAxisController::setDoubleParam(int list, int index, double value)
+{
+  if ((list >= 0) && (list < numAxes_) && pAxes_[list])
+    pAxes_[list]->updateSettings(index, value);
+  return asynPortDriver::setDoubleParam(list, index, value);
+}
+
 /** Called when asyn clients call pasynInt32->write().
   * Extracts the function and axis number from pasynUser.
   * Sets the value in the parameter library.
@@ -211,10 +382,10 @@ asynStatus asynAxisController::writeInt32(asynUser *pasynUser, epicsInt32 value)
   pAxis->setIntegerParam(function, value);
 
   if (function == motorStop_) {
-    double accel;
-    getDoubleParam(axis, motorAccel_, &accel);
     pAxis->setIntegerParam(motorLatestCommand_, LATEST_COMMAND_STOP);
-    status = pAxis->stop(accel);
+    status = pAxis->stop(pAxis->settings_.accel);
+    /* After a stop, done from the controller is valid whatever move it belongs to */
+    pAxis->forceMoveSequenceDone();
   
   } else if (function == motorDeferMoves_) {
     status = setDeferredMoves(value);
@@ -222,17 +393,32 @@ asynStatus asynAxisController::writeInt32(asynUser *pasynUser, epicsInt32 value)
   } else if (function == motorClosedLoop_) {
     status = pAxis->setClosedLoop(value);
 
+  } else if (function == motorLatencyTrace_) {
+    setLatencyTrace(value);
+
   } else if (function == motorUpdateStatus_) {
     bool moving;
-    /* Do a poll, and then force a callback */
-    poll();
-    if (!pAxis->initialPollDone_) {
-      asynStatus asynstatus;
-      asynstatus = pAxis->initialPoll();
-      if (asynstatus == asynSuccess) pAxis->initialPollDone_ = 1;
+    if (value == MOTOR_UPDATE_STATUS_INIT) {
+      /* One pass over the controller serves the records of all axes */
+      if (!pAxis->polled_) pollUnpolledAxes();
+      pAxis->statusChanged_ = 1;
+    } else if (pollerStarted_) {
+      /* Requests that come in before the poller runs share its poll,
+       * which forces a callback for every axis that asked */
+      pAxis->updateStatusRequested_ = 1;
+      wakeupPoller();
+    } else {
+      /* Do a poll, and then force a callback */
+      poll();
+      if (!pAxis->initialPollDone_) {
+        asynStatus asynstatus;
+        asynstatus = pAxis->initialPoll();
+        if (asynstatus == asynSuccess) pAxis->initialPollDone_ = 1;
+      }
+      status = pAxis->poll(&moving);
+      pAxis->polled_ = 1;
+      pAxis->statusChanged_ = 1;
     }
-    status = pAxis->poll(&moving);
-    pAxis->statusChanged_ = 1;
 
   } else if (function == profileBuild_) {
     status = buildProfile();
@@ -249,6 +435,8 @@ asynStatus asynAxisController::writeInt32(asynUser *pasynUser, epicsInt32 value)
   } else if (function == motorMoveToHome_) {
     if (value == 1) {
       pAxis->setIntegerParam(motorLatestCommand_, LATEST_COMMAND_MOVE_TO_HOME);
+      pAxis->newMoveSequence();
+      pAxis->commandedVelocity_ = pAxis->settings_.velocity;
       asynPrint(pasynUser, ASYN_TRACE_FLOW, 
         "%s:%s:: Starting a move to home for axis %d\n",  driverName, functionName, axis);
       moveToHomeAxis_ = axis;
@@ -287,32 +475,39 @@ asynStatus asynAxisController::writeFloat64(asynUser *pasynUser, epicsFloat64 va
   asynAxisAxis *pAxis;
   int axis;
   int forwards;
-  int autoPower = 0;
-  double autoPowerOnDelay = 0.0;
+  int autoPower;
+  double autoPowerOnDelay;
   asynStatus status = asynError;
   static const char *functionName = "writeFloat64";
 
   pAxis = getAxis(pasynUser);
   if (!pAxis) return asynError;
   axis = pAxis->axisNo_;
-
-  getIntegerParam(axis, motorPowerAutoOnOff_, &autoPower);
-  getDoubleParam(axis, motorPowerOnDelay_, &autoPowerOnDelay);
+  if (latencyTrace_) epicsTimeGetCurrent(&pAxis->latencyCommandTime_);
 
   /* Set the parameter and readback in the parameter library. */
   status = pAxis->setDoubleParam(function, value);
 
+  /* Use the cached settings, they are kept up to date by pAxis->setXXXParam() */
+  autoPower        = pAxis->settings_.powerAutoOnOff;
+  autoPowerOnDelay = pAxis->settings_.powerOnDelay;
+  baseVelocity     = pAxis->settings_.velBase;
+  velocity         = pAxis->settings_.velocity;
+  acceleration     = pAxis->settings_.accel;
+
   if (function == motorMoveRel_) {
     if (autoPower == 1) {
       status = pAxis->setClosedLoop(true);
       epicsThreadSleep(autoPowerOnDelay);
     }
-    getDoubleParam(axis, motorVelBase_, &baseVelocity);
-    getDoubleParam(axis, motorVelocity_, &velocity);
-    getDoubleParam(axis, motorAccel_, &acceleration);
     pAxis->setIntegerParam(motorLatestCommand_, LATEST_COMMAND_MOVE_REL);
-    status = pAxis->move(value, 1, baseVelocity, velocity, acceleration);
+    pAxis->newMoveSequence();
+    pAxis->commandedVelocity_ = velocity;
+    status = pAxis->startMove(value, 1, baseVelocity, velocity, acceleration);
+    if (latencyTrace_) pAxis->traceMoveReturn();
     pAxis->setIntegerParam(motorStatusDone_, 0);
+    /* If the command failed, the controller will not report it as done */
+    if (status) pAxis->forceMoveSequenceDone();
     pAxis->waitNumPollsBeforeReady_ = 
       pAxis->defWaitNumPollsBeforeReady_;
     pAxis->callParamCallbacks();
@@ -321,17 +516,35 @@ asynStatus asynAxisController::writeFloat64(asynUser *pasynUser, epicsFloat64 va
       "%s:%s: Set driver %s, axis %d move relative by %f, base velocity=%f, velocity=%f, acceleration=%f\n",
       driverName, functionName, portName, pAxis->axisNo_, value, baseVelocity, velocity, acceleration );
   
+  } else if (function == motorRetarget_) {
+    /* New target of the move in progress. If the driver can't, start
+       a move to it, the controller may have finished the old one */
+    pAxis->newMoveSequence();
+    status = pAxis->retarget(value);
+    if (status) status = pAxis->move(value, 0, baseVelocity, velocity, acceleration);
+    pAxis->setIntegerParam(motorStatusDone_, 0);
+    if (status) pAxis->forceMoveSequenceDone();
+    pAxis->waitNumPollsBeforeReady_ = 
+      pAxis->defWaitNumPollsBeforeReady_;
+    pAxis->callParamCallbacks();
+    wakeupPoller();
+    asynPrint(pasynUser, ASYN_TRACE_FLOW, 
+      "%s:%s: Set driver %s, axis %d retarget to %f, status=%d\n",
+      driverName, functionName, portName, pAxis->axisNo_, value, (int)status);
+
   } else if (function == motorMoveAbs_) {
     if (autoPower == 1) {
       status = pAxis->setClosedLoop(true);
       epicsThreadSleep(autoPowerOnDelay);
     }
-    getDoubleParam(axis, motorVelBase_, &baseVelocity);
-    getDoubleParam(axis, motorVelocity_, &velocity);
-    getDoubleParam(axis, motorAccel_, &acceleration);
     pAxis->setIntegerParam(motorLatestCommand_, LATEST_COMMAND_MOVE_ABS);
-    status = pAxis->move(value, 0, baseVelocity, velocity, acceleration);
+    pAxis->newMoveSequence();
+    pAxis->commandedVelocity_ = velocity;
+    status = pAxis->startMove(value, 0, baseVelocity, velocity, acceleration);
+    if (latencyTrace_) pAxis->traceMoveReturn();
     pAxis->setIntegerParam(motorStatusDone_, 0);
+    /* If the command failed, the controller will not report it as done */
+    if (status) pAxis->forceMoveSequenceDone();
     pAxis->waitNumPollsBeforeReady_ = 
       pAxis->defWaitNumPollsBeforeReady_;
     pAxis->callParamCallbacks();
@@ -345,11 +558,14 @@ asynStatus asynAxisController::writeFloat64(asynUser *pasynUser, epicsFloat64 va
       status = pAxis->setClosedLoop(true);
       epicsThreadSleep(autoPowerOnDelay);
     }
-    getDoubleParam(axis, motorVelBase_, &baseVelocity);
-    getDoubleParam(axis, motorAccel_, &acceleration);
     pAxis->setIntegerParam(motorLatestCommand_, LATEST_COMMAND_MOVE_VEL);
+    pAxis->newMoveSequence();
+    pAxis->commandedVelocity_ = value;
     status = pAxis->moveVelocity(baseVelocity, value, acceleration);
+    if (latencyTrace_) pAxis->traceMoveReturn();
     pAxis->setIntegerParam(motorStatusDone_, 0);
+    /* If the command failed, the controller will not report it as done */
+    if (status) pAxis->forceMoveSequenceDone();
     pAxis->waitNumPollsBeforeReady_ = 
       pAxis->defWaitNumPollsBeforeReady_;
     pAxis->callParamCallbacks();
@@ -364,13 +580,15 @@ asynStatus asynAxisController::writeFloat64(asynUser *pasynUser, epicsFloat64 va
       status = pAxis->setClosedLoop(true);
       epicsThreadSleep(autoPowerOnDelay);
     }
-    getDoubleParam(axis, motorVelBase_, &baseVelocity);
-    getDoubleParam(axis, motorVelocity_, &velocity);
-    getDoubleParam(axis, motorAccel_, &acceleration);
     forwards = (value == 0) ? 0 : 1;
     pAxis->setIntegerParam(motorLatestCommand_, LATEST_COMMAND_HOMING);
+    pAxis->newMoveSequence();
+    pAxis->commandedVelocity_ = velocity;
     status = pAxis->home(baseVelocity, velocity, acceleration, forwards);
+    if (latencyTrace_) pAxis->traceMoveReturn();
     pAxis->setIntegerParam(motorStatusDone_, 0);
+    /* If the command failed, the controller will not report it as done */
+    if (status) pAxis->forceMoveSequenceDone();
     pAxis->waitNumPollsBeforeReady_ = 
       pAxis->defWaitNumPollsBeforeReady_;
     pAxis->callParamCallbacks();
@@ -564,6 +782,56 @@ asynStatus asynAxisController::readGenericPointer(asynUser *pasynUser, void *poi
   return status;
 }  
 
+/** Called when asyn clients call pasynGenericPointer->write().
+  * If the function is motorMoveCompound_, the pointer is a MotorMoveCompound.
+  * The velocities and the acceleration in it are stored in the parameter library,
+  * and the move is then started with writeFloat64() as if device support had
+  * written the move parameter, so that derived classes see the usual call.
+  * An absolute or relative move is started by asynAxisAxis::startMove(), which
+  * handles MOTOR_COMPOUND_BACKLASH and MOTOR_COMPOUND_RETRY.
+  * Settings, move and callbacks are all done while holding the port lock once.
+  * \param[in] pasynUser asynUser structure that encodes the reason and address.
+  * \param[in] pointer Pointer to the MotorMoveCompound object. */
+asynStatus asynAxisController::writeGenericPointer(asynUser *pasynUser, void *pointer)
+{
+  MotorMoveCompound *pMove = (MotorMoveCompound *)pointer;
+  int function = pasynUser->reason;
+  asynAxisAxis *pAxis;
+  asynStatus status;
+  static const char *functionName = "writeGenericPointer";
+
+  if (function != motorMoveCompound_)
+    return asynPortDriver::writeGenericPointer(pasynUser, pointer);
+
+  pAxis = getAxis(pasynUser);
+  if (!pAxis) return asynError;
+
+  if (pMove->mask & MOTOR_COMPOUND_VEL_BASE) pAxis->setDoubleParam(motorVelBase_, pMove->velBase);
+  if (pMove->mask & MOTOR_COMPOUND_VELOCITY) pAxis->setDoubleParam(motorVelocity_, pMove->velocity);
+  if (pMove->mask & MOTOR_COMPOUND_ACCEL)    pAxis->setDoubleParam(motorAccel_, pMove->accel);
+
+  switch (pMove->command) {
+    case MOTOR_COMPOUND_MOVE_ABS: pasynUser->reason = motorMoveAbs_; break;
+    case MOTOR_COMPOUND_MOVE_REL: pasynUser->reason = motorMoveRel_; break;
+    case MOTOR_COMPOUND_MOVE_VEL: pasynUser->reason = motorMoveVel_; break;
+    case MOTOR_COMPOUND_HOME:     pasynUser->reason = motorHome_;    break;
+    default:
+      asynPrint(pasynUser, ASYN_TRACE_ERROR,
+        "%s:%s: port %s, axis %d unknown compound command %d\n",
+        driverName, functionName, portName, pAxis->axisNo_, pMove->command);
+      return asynError;
+  }
+  asynPrint(pasynUser, ASYN_TRACE_FLOW,
+    "%s:%s: port %s, axis %d compound command %d value=%f mask=0x%x\n",
+    driverName, functionName, portName, pAxis->axisNo_, pMove->command,
+    pMove->value, pMove->mask);
+  pAxis->compoundMove_ = pMove;
+  status = writeFloat64(pasynUser, pMove->value);
+  pAxis->compoundMove_ = NULL;
+  pasynUser->reason = function;
+  return status;
+}
+
 /** Called when asyn clients call pasynOctetSyncIO->write().
   * Extracts the function and axis number from pasynUser.
   * Sets the value in the parameter library.
@@ -600,6 +868,83 @@ asynAxisAxis* asynAxisController::getAxis(asynUser *pasynUser)
     return getAxis(axisNo);
 }
 
+/** Polls all axes that have not been polled since the IOC started.
+  * Used during IOC init, so that the records of a controller need one pass
+  * over the controller together rather than one poll each.
+  * The records that come later get the values from this pass, or from the poller
+  * if it has already been round. */
+void asynAxisController::pollUnpolledAxes()
+{
+  asynAxisAxis *pAxis;
+  bool moving;
+  int i;
+
+  poll();
+  for (i=0; i<numAxes_; i++) {
+    pAxis = getAxis(i);
+    if (!pAxis || pAxis->polled_) continue;
+    if (!pAxis->initialPollDone_) {
+      if (pAxis->initialPoll() == asynSuccess) pAxis->initialPollDone_ = 1;
+    }
+    pAxis->poll(&moving);
+    pAxis->polled_ = 1;
+  }
+}
+
+/** Announces a stop that is about to be queued.
+  * Called without the port lock. Until endStop() the poller releases the lock
+  * between axes, so that the stop does not wait for a complete poll cycle.
+  * Calls the fastStop() hook of the axis, which drivers with a separate
+  * channel to the controller may implement.
+  * \param[in] axis The axis to stop.
+  * \return 1 if fastStop() has sent the stop, 0 otherwise. */
+int asynAxisController::beginStop(int axis)
+{
+  asynAxisAxis *pAxis = getAxis(axis);
+
+  epicsAtomicIncrIntT(&stopsPending_);
+  if (!pAxis) return 0;
+  return pAxis->fastStop(pAxis->settings_.accel) == asynSuccess;
+}
+
+/** The stop announced by beginStop() has been handed to the driver. */
+void asynAxisController::endStop()
+{
+  epicsAtomicDecrIntT(&stopsPending_);
+}
+
+/** Switches the latency trace of moves on or off.
+  * While it is on, the time from writeFloat64() to the return of move(), to the first
+  * poll that shows the axis moving and to the poll that shows it done is put into
+  * MOTOR_LATENCY_COMMAND, MOTOR_LATENCY_START and MOTOR_LATENCY_DONE of the axis,
+  * and counted in histograms that are shown by report().
+  * Switching it on clears the histograms. Called with the port lock.
+  * \param[in] enable 1 to switch the trace on, 0 to switch it off. */
+void asynAxisController::setLatencyTrace(int enable)
+{
+  int i;
+
+  enable = enable ? 1 : 0;
+  if (enable && !latencyTrace_) memset(latencyHistogram_, 0, sizeof(latencyHistogram_));
+  latencyTrace_ = enable;
+  for (i=0; i<numAxes_; i++) {
+    setIntegerParam(i, motorLatencyTrace_, enable);
+    callParamCallbacks(i);
+  }
+}
+
+/** Counts a stage of a traced move in its histogram. Called with the port lock.
+  * \param[in] stage One of MotorLatencyStage.
+  * \param[in] latency The time the stage took in seconds. */
+void asynAxisController::addLatency(int stage, double latency)
+{
+  int i;
+
+  for (i=0; i<MOTOR_LATENCY_BINS-1; i++)
+    if (latency < latencyLimits[i]) break;
+  latencyHistogram_[stage][i]++;
+}
+
 /** Processes deferred moves.
   * \param[in] deferMoves defer moves till later (true) or process moves now (false) */
 asynStatus asynAxisController::setDeferredMoves(bool deferMoves)
@@ -632,6 +977,7 @@ asynStatus asynAxisController::startPoller(double movingPollPeriod, double idleP
   movingPollPeriod_ = movingPollPeriod;
   idlePollPeriod_   = idlePollPeriod;
   forcedFastPolls_  = forcedFastPolls;
+  pollerStarted_ = 1;
   epicsThreadCreate("motorPoller", 
                     epicsThreadPriorityLow,
                     epicsThreadGetStackSize(epicsThreadStackMedium),
@@ -662,6 +1008,46 @@ asynStatus asynAxisController::poll()
   return asynSuccess;
 }
 
+/** Waits for the next poll.
+  * When setEstimatePeriod() is in use and any axis is moving, the wait is split into
+  * steps of estimatePeriod_, and estimated positions are published after each step.
+  * \param[in] timeout The time until the next poll, 0 means wait for an event.
+  * \param[in] anyMoving Any axis was moving in the latest poll. */
+int asynAxisController::waitForNextPoll(double timeout, bool anyMoving)
+{
+  epicsTimeStamp startTime, nowTime;
+  double remaining;
+  int i;
+  int status;
+  asynAxisAxis *pAxis;
+
+  if ((estimatePeriod_ <= 0.0) || !anyMoving || (timeout <= estimatePeriod_)) {
+    if (timeout != 0.) return epicsEventWaitWithTimeout(pollEventId_, timeout);
+    return epicsEventWait(pollEventId_);
+  }
+  epicsTimeGetCurrent(&startTime);
+  remaining = timeout;
+  while (1) {
+    status = epicsEventWaitWithTimeout(pollEventId_,
+                                       remaining < estimatePeriod_ ? remaining : estimatePeriod_);
+    if (status != epicsEventWaitTimeout) return status;
+    epicsTimeGetCurrent(&nowTime);
+    remaining = timeout - epicsTimeDiffInSeconds(&nowTime, &startTime);
+    if (remaining <= 0.0) return status;
+    lock();
+    if (shuttingDown_) {
+      unlock();
+      return status;
+    }
+    for (i=0; i<numAxes_; i++) {
+      pAxis = getAxis(i);
+      if (!pAxis) continue;
+      pAxis->publishEstimatedPosition(movingPollPeriod_);
+    }
+    unlock();
+  }
+}
+
 static void asynMotorPollerC(void *drvPvt)
 {
   asynAxisController *pController = (asynAxisController*)drvPvt;
@@ -680,7 +1066,7 @@ void asynAxisController::asynMotorPoller()
   double timeout;
   int i;
   int forcedFastPolls=0;
-  bool anyMoving;
+  bool anyMoving = false;
   bool moving;
   epicsTimeStamp nowTime;
   double nowTimeSecs = 0.0;
@@ -693,8 +1079,7 @@ void asynAxisController::asynMotorPoller()
   wakeupPoller();  /* Force on poll at startup */
 
   while(1) {
-    if (timeout != 0.) status = epicsEventWaitWithTimeout(pollEventId_, timeout);
-    else               status = epicsEventWait(pollEventId_);
+    status = waitForNextPoll(timeout, anyMoving);
     if (status == epicsEventWaitOK) {
       /* We got an event, rather than a timeout.  This is because other software
        * knows that an axis should have changed state (started moving, etc.).
@@ -733,6 +1118,12 @@ void asynAxisController::asynMotorPoller()
     }
     poll();
     for (i=0; i<numAxes_; i++) {
+      /* A stop is waiting for the lock, let it in between two axes */
+      if (i && epicsAtomicGetIntT(&stopsPending_)) {
+        unlock();
+        epicsThreadSleep(0.);
+        lock();
+      }
       pAxis=getAxis(i);
       if (!pAxis) continue;
 
@@ -741,10 +1132,28 @@ void asynAxisController::asynMotorPoller()
           asynstatus = pAxis->initialPoll();
           if (asynstatus == asynSuccess) pAxis->initialPollDone_ = 1;
       }
-      getIntegerParam(i, motorPowerAutoOnOff_, &autoPower);
-      getDoubleParam(i, motorPowerOffDelay_, &autoPowerOffDelay);
+      autoPower = pAxis->settings_.powerAutoOnOff;
+      autoPowerOffDelay = pAxis->settings_.powerOffDelay;
       
       pAxis->poll(&moving);
+      pAxis->polled_ = 1;
+      /* The move of a moveWithBacklash() is done, start the approach,
+         or a correction of the retries in the driver.
+         Not while a stop is on its way, it may be for this axis */
+      if (!epicsAtomicGetIntT(&stopsPending_)) {
+        if (pAxis->backlashState_ == 2) {
+          if (pAxis->startBacklashMove()) moving = true;
+        } else if (pAxis->retryState_ == 2) {
+          if (pAxis->startRetryMove()) moving = true;
+        }
+      }
+      if (pAxis->latencyState_) pAxis->traceMovePoll(moving);
+      if (pAxis->updateStatusRequested_) {
+        /* Asked for by MOTOR_UPDATE_STATUS, always do the callback */
+        pAxis->updateStatusRequested_ = 0;
+        pAxis->statusChanged_ = 1;
+        pAxis->callParamCallbacks();
+      }
       if (moving) {
 	anyMoving = true;
 	pAxis->setWasMovingFlag(1);
@@ -910,8 +1319,14 @@ asynStatus asynAxisController::initializeProfile(size_t maxProfilePoints)
 {
   int axis;
   asynAxisAxis *pAxis;
-  // static const char *functionName = "initializeProfile";
+  static const char *functionName = "initializeProfile";
   
+  if (!controllerParamsCreated_) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: port=%s createControllerParams() has not been called\n",
+      driverName, functionName, portName);
+    return asynError;
+  }
   maxProfilePoints_ = maxProfilePoints;
   if (profileTimes_) free(profileTimes_);
   profileTimes_ = (double *)calloc(maxProfilePoints, sizeof(double));
@@ -1029,6 +1444,57 @@ asynStatus asynAxisController::setIdlePollPeriod(double idlePollPeriod)
   return asynSuccess;
 }
 
+/** Set the period (in secs) for publishing estimated positions between polls at runtime.
+  * While an axis is moving, its positions are extrapolated from the last two polls,
+  * flagged with STATUS_BIT_ESTIMATED, and corrected by the next poll.
+  * 0 switches this off. */
+asynStatus asynAxisController::setEstimatePeriod(double estimatePeriod)
+{
+  static const char *functionName = "setEstimatePeriod";
+
+  asynPrint(pasynUserSelf, ASYN_TRACE_FLOW,
+    "%s:%s: Setting estimate period to %f\n",
+    driverName, functionName, estimatePeriod);
+
+  lock();
+  estimatePeriod_ = estimatePeriod > 0.0 ? estimatePeriod : 0.0;
+  wakeupPoller();
+  unlock();
+  return asynSuccess;
+}
+
+/** Set the position deadband and the minimum interval between position-only
+  * status callbacks at runtime.
+  * \param[in] axis Axis number, -1 means all axes of this controller.
+  * \param[in] deadband Deadband in steps.
+  * \param[in] minCallbackInterval Minimum time between callbacks in seconds. */
+asynStatus asynAxisController::setPositionDeadband(int axis, double deadband, double minCallbackInterval)
+{
+  asynAxisAxis *pAxis;
+  int i;
+  static const char *functionName = "setPositionDeadband";
+
+  if (axis >= 0 && !getAxis(axis)) {
+    asynPrint(pasynUserSelf, ASYN_TRACE_ERROR,
+      "%s:%s: Error axis %d not found\n",
+      driverName, functionName, axis);
+    return asynError;
+  }
+  asynPrint(pasynUserSelf, ASYN_TRACE_FLOW,
+    "%s:%s: axis=%d deadband=%f minCallbackInterval=%f\n",
+    driverName, functionName, axis, deadband, minCallbackInterval);
+
+  lock();
+  for (i=0; i<numAxes_; i++) {
+    if ((axis >= 0) && (i != axis)) continue;
+    pAxis = getAxis(i);
+    if (!pAxis) continue;
+    pAxis->setPositionDeadband(deadband, minCallbackInterval);
+  }
+  unlock();
+  return asynSuccess;
+}
+
 /** The following functions have C linkage, and can be called directly or from iocsh */
 
 extern "C" {
@@ -1047,6 +1513,30 @@ asynStatus setMovingPollPeriod(const char *portName, double movingPollPeriod)
   return pC->setMovingPollPeriod(movingPollPeriod);
 }
 
+void *asynAxisControllerFind(const char *portName)
+{
+  return asynAxisController::findController(portName);
+}
+
+int asynAxisControllerStopBegin(void *pController, int axis)
+{
+  return ((asynAxisController *)pController)->beginStop(axis);
+}
+
+void asynAxisControllerStopEnd(void *pController)
+{
+  ((asynAxisController *)pController)->endStop();
+}
+
+void asynAxisControllerLatencyTrace(void *pController, int enable)
+{
+  asynAxisController *pC = (asynAxisController *)pController;
+
+  pC->lock();
+  pC->setLatencyTrace(enable);
+  pC->unlock();
+}
+
 asynStatus setIdlePollPeriod(const char *portName, double idlePollPeriod)
 {
   asynAxisController *pC;
@@ -1062,6 +1552,20 @@ asynStatus setIdlePollPeriod(const char *portName, double idlePollPeriod)
 }
 
 
+asynStatus asynAxisSetEstimatePeriod(const char *portName, double estimatePeriod)
+{
+  asynAxisController *pC;
+  static const char *functionName = "asynAxisSetEstimatePeriod";
+
+  pC = (asynAxisController*) findAsynPortDriver(portName);
+  if (!pC) {
+    printf("%s:%s: Error port %s not found\n", driverName, functionName, portName);
+    return asynError;
+  }
+
+  return pC->setEstimatePeriod(estimatePeriod);
+}
+
 
 asynStatus asynMotorEnableMoveToHome(const char *portName, int axis, int distance)
 {
@@ -1090,6 +1594,21 @@ asynStatus asynMotorEnableMoveToHome(const char *portName, int axis, int distanc
   return asynSuccess;
 }
 
+asynStatus asynAxisSetPositionDeadband(const char *portName, int axis,
+                                       double deadband, double minCallbackInterval)
+{
+  asynAxisController *pC;
+  static const char *functionName = "asynAxisSetPositionDeadband";
+
+  pC = (asynAxisController*) findAsynPortDriver(portName);
+  if (!pC) {
+    printf("%s:%s: Error port %s not found\n", driverName, functionName, portName);
+    return asynError;
+  }
+
+  return pC->setPositionDeadband(axis, deadband, minCallbackInterval);
+}
+
 
 /* setMovingPollPeriod */
 static const iocshArg setMovingPollPeriodArg0 = {"Controller port name", iocshArgString};
@@ -1115,6 +1634,18 @@ static void setIdlePollPeriodCallFunc(const iocshArgBuf *args)
   setIdlePollPeriod(args[0].sval, args[1].dval);
 }
 
+/* asynAxisSetEstimatePeriod */
+static const iocshArg asynAxisSetEstimatePeriodArg0 = {"Controller port name", iocshArgString};
+static const iocshArg asynAxisSetEstimatePeriodArg1 = {"Estimate period", iocshArgDouble};
+static const iocshArg * const asynAxisSetEstimatePeriodArgs[] = {&asynAxisSetEstimatePeriodArg0,
+                                                                 &asynAxisSetEstimatePeriodArg1};
+static const iocshFuncDef setEstimatePeriodDef = {"asynAxisSetEstimatePeriod", 2, asynAxisSetEstimatePeriodArgs};
+
+static void setEstimatePeriodCallFunc(const iocshArgBuf *args)
+{
+  asynAxisSetEstimatePeriod(args[0].sval, args[1].dval);
+}
+
 
 /* asynMotorEnableMoveToHome */
 static const iocshArg asynMotorEnableMoveToHomeArg0 = {"Controller port name", iocshArgString};
@@ -1130,12 +1661,30 @@ static void enableMoveToHomeCallFunc(const iocshArgBuf *args)
   asynMotorEnableMoveToHome(args[0].sval, args[1].ival, args[2].ival);
 }
 
+/* asynAxisSetPositionDeadband */
+static const iocshArg asynAxisSetPositionDeadbandArg0 = {"Controller port name", iocshArgString};
+static const iocshArg asynAxisSetPositionDeadbandArg1 = {"Axis number (-1 = all)", iocshArgInt};
+static const iocshArg asynAxisSetPositionDeadbandArg2 = {"Deadband in steps", iocshArgDouble};
+static const iocshArg asynAxisSetPositionDeadbandArg3 = {"Min callback interval", iocshArgDouble};
+static const iocshArg * const asynAxisSetPositionDeadbandArgs[] = {&asynAxisSetPositionDeadbandArg0,
+                                                                   &asynAxisSetPositionDeadbandArg1,
+                                                                   &asynAxisSetPositionDeadbandArg2,
+                                                                   &asynAxisSetPositionDeadbandArg3};
+static const iocshFuncDef setPositionDeadband = {"asynAxisSetPositionDeadband", 4, asynAxisSetPositionDeadbandArgs};
+
+static void setPositionDeadbandCallFunc(const iocshArgBuf *args)
+{
+  asynAxisSetPositionDeadband(args[0].sval, args[1].ival, args[2].dval, args[3].dval);
+}
+
 
 static void asynAxisControllerRegister(void)
 {
   iocshRegister(&setMovingPollPeriodDef, setMovingPollPeriodCallFunc);
   iocshRegister(&setIdlePollPeriodDef, setIdlePollPeriodCallFunc);
+  iocshRegister(&setEstimatePeriodDef, setEstimatePeriodCallFunc);
   iocshRegister(&enableMoveToHome, enableMoveToHomeCallFunc);
+  iocshRegister(&setPositionDeadband, setPositionDeadbandCallFunc);
 }
 epicsExportRegistrar(asynAxisControllerRegister);
 
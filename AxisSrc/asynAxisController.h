@@ -51,6 +51,12 @@
 #define motorMessageIsFromDriverString  "MOTOR_MESSAGE_DRIVER"
 #define motorMessageTextString          "MOTOR_MESSAGE_TEXT"
 #define motorUpdateStatusString         "MOTOR_UPDATE_STATUS"
+#define motorMoveCompoundString         "MOTOR_MOVE_COMPOUND"
+#define motorLatencyTraceString         "MOTOR_LATENCY_TRACE"
+#define motorLatencyCommandString       "MOTOR_LATENCY_COMMAND"
+#define motorLatencyStartString         "MOTOR_LATENCY_START"
+#define motorLatencyDoneString          "MOTOR_LATENCY_DONE"
+#define motorRetargetString             "MOTOR_RETARGET"
 #define motorStatusDirectionString      "MOTOR_STATUS_DIRECTION" 
 #define motorStatusDoneString           "MOTOR_STATUS_DONE"
 #define motorStatusHighLimitString      "MOTOR_STATUS_HIGH_LIMIT"
@@ -70,6 +76,7 @@
 /* Addition flags which can be set by the specific driver */
 #define motorFlagsHomeOnLsString        "MOTOR_FLAGSS_HOME_ON_LS"
 #define motorFlagsStopOnProblemString   "MOTOR_FLAGS_STOP_ON_PROBLEM"
+#define motorFlagsRetargetString        "MOTOR_FLAGS_RETARGET"
 
 /* Not homed is ignored, shown, problem */
 #define motorNotHomedProblemString    "MOTOR_NOT_HOMED_PROBLEM"
@@ -139,6 +146,7 @@
 #define STATUS_BIT_COMMS_ERROR     (1<<12)
 #define STATUS_BIT_LOW_LIMIT       (1<<13)
 #define STATUS_BIT_HOMED           (1<<14)
+#define STATUS_BIT_ESTIMATED       (1<<15) /* Positions are extrapolated, not polled */
 
 
 typedef struct MotorConfigRO {
@@ -162,6 +170,65 @@ typedef struct MotorStatus {
   struct MotorConfigRO MotorConfigRO;
 } MotorStatus;
 
+/* Stages of a move timed by the latency trace of the driver, see MOTOR_LATENCY_TRACE */
+enum MotorLatencyStage {
+  MOTOR_LATENCY_COMMAND,     /* writeFloat64() entry to the return of move() */
+  MOTOR_LATENCY_START,       /* Return of move() to the first poll that shows moving */
+  MOTOR_LATENCY_DONE,        /* Return of move() to the poll that shows done */
+  MOTOR_LATENCY_STAGES
+};
+#define MOTOR_LATENCY_BINS 8
+
+/* Values written to MOTOR_UPDATE_STATUS */
+#define MOTOR_UPDATE_STATUS_POLL 1  /* Poll the axis, in the next poll cycle if the poller runs */
+#define MOTOR_UPDATE_STATUS_INIT 2  /* IOC init, a poll since the IOC started is good enough */
+
+/* Commands in MotorMoveCompound */
+enum MotorCompoundCommand {
+  MOTOR_COMPOUND_MOVE_ABS,
+  MOTOR_COMPOUND_MOVE_REL,
+  MOTOR_COMPOUND_MOVE_VEL,
+  MOTOR_COMPOUND_HOME
+};
+
+/* Bits in MotorMoveCompound.mask, the settings that are sent with the move */
+#define MOTOR_COMPOUND_VEL_BASE (1<<0)
+#define MOTOR_COMPOUND_VELOCITY (1<<1)
+#define MOTOR_COMPOUND_ACCEL    (1<<2)
+#define MOTOR_COMPOUND_BACKLASH (1<<3) /* MOVE_ABS or MOVE_REL with a backlash approach */
+#define MOTOR_COMPOUND_RETRY    (1<<4) /* MOVE_ABS or MOVE_REL with retries in the driver */
+
+/** The structure that devMotorAsyn writes to MOTOR_MOVE_COMPOUND.
+  * It carries a complete move, so that the motion settings and the move
+  * itself reach the driver in one request. */
+typedef struct MotorMoveCompound {
+  int command;               /**< One of MotorCompoundCommand */
+  double value;              /**< Target, relative distance, velocity or home direction */
+  double velBase;            /**< Base velocity, steps/sec */
+  double velocity;           /**< Velocity, steps/sec */
+  double accel;              /**< Acceleration, steps/sec/sec */
+  epicsUInt32 mask;          /**< Which of the settings are valid */
+  double backlashValue;      /**< Final position, relative to the end of the move for MOVE_REL */
+  double backlashVelocity;   /**< Velocity of the approach, steps/sec */
+  double backlashAccel;      /**< Acceleration of the approach, steps/sec/sec */
+  double retryDeadband;      /**< In position within this many steps */
+  int retryCount;            /**< Maximum number of corrections */
+  double retryFraction;      /**< Fraction of the error moved by a correction */
+  int retryUseEncoder;       /**< The error is from the encoder position, else from the position */
+} MotorMoveCompound;
+
+/* Low latency stop, called by devMotorAsyn without the port lock */
+#ifdef __cplusplus
+extern "C" {
+#endif
+epicsShareFunc void *asynAxisControllerFind(const char *portName);
+epicsShareFunc int asynAxisControllerStopBegin(void *pController, int axis);
+epicsShareFunc void asynAxisControllerStopEnd(void *pController);
+epicsShareFunc void asynAxisControllerLatencyTrace(void *pController, int enable);
+#ifdef __cplusplus
+}
+#endif
+
 enum ProfileTimeMode{
   PROFILE_TIME_MODE_FIXED,
   PROFILE_TIME_MODE_ARRAY
@@ -219,6 +286,12 @@ enum LatestCommand {
 
 class asynAxisAxis;
 
+/** Name and index of a motor parameter, for the lookup in drvUserCreate() */
+typedef struct MotorParamName {
+  const char *name;
+  int index;
+} MotorParamName;
+
 class epicsShareClass asynAxisController : public asynPortDriver {
 
   public:
@@ -230,11 +303,18 @@ class epicsShareClass asynAxisController : public asynPortDriver {
   virtual ~asynAxisController();
 
   /* These are the methods that we override from asynPortDriver */
+  using asynPortDriver::setIntegerParam;
+  virtual asynStatus setIntegerParam(int list, int index, int value);
+  using asynPortDriver::setDoubleParam;
+  virtual asynStatus setDoubleParam(int list, int index, double value);
+  virtual asynStatus drvUserCreate(asynUser *pasynUser, const char *drvInfo,
+                                   const char **pptypeName, size_t *psize);
   virtual asynStatus writeInt32(asynUser *pasynUser, epicsInt32 value);
   virtual asynStatus writeFloat64(asynUser *pasynUser, epicsFloat64 value);
   virtual asynStatus writeFloat64Array(asynUser *pasynUser, epicsFloat64 *value, size_t nElements);
   virtual asynStatus readFloat64Array(asynUser *pasynUser, epicsFloat64 *value, size_t nElements, size_t *nRead);
   virtual asynStatus readGenericPointer(asynUser *pasynUser, void *pointer);
+  virtual asynStatus writeGenericPointer(asynUser *pasynUser, void *pointer);
   virtual asynStatus writeOctet(asynUser *pasynUser, const char *value, size_t nChars, size_t *nActual);
   virtual void report(FILE *fp, int details);
 
@@ -252,6 +332,7 @@ class epicsShareClass asynAxisController : public asynPortDriver {
   void asynMotorMoveToHome();
   
   /* These are the functions for profile moves */
+  void createControllerParams();
   virtual asynStatus initializeProfile(size_t maxPoints);
   virtual asynStatus buildProfile();
   virtual asynStatus executeProfile();
@@ -260,6 +341,12 @@ class epicsShareClass asynAxisController : public asynPortDriver {
   
   virtual asynStatus setMovingPollPeriod(double movingPollPeriod);
   virtual asynStatus setIdlePollPeriod(double idlePollPeriod);
+  virtual asynStatus setPositionDeadband(int axis, double deadband, double minCallbackInterval);
+  virtual asynStatus setEstimatePeriod(double estimatePeriod);
+  int beginStop(int axis);
+  void endStop();
+  void setLatencyTrace(int enable);
+  static asynAxisController *findController(const char *portName);
 
   int shuttingDown_;   /**< Flag indicating that IOC is shutting down.  Stops poller */
 
@@ -298,6 +385,12 @@ class epicsShareClass asynAxisController : public asynPortDriver {
   int motorLatestCommand_;
   int motorMessageIsFromDriver_;
   int motorMessageText_;
+  int motorMoveCompound_;
+  int motorLatencyTrace_;
+  int motorLatencyCommand_;
+  int motorLatencyStart_;
+  int motorLatencyDone_;
+  int motorRetarget_;
 
   // These are the status bits
   int motorStatusDirection_;
@@ -324,6 +417,7 @@ class epicsShareClass asynAxisController : public asynPortDriver {
    */
   int motorFlagsHomeOnLs_;
   int motorFlagsStopOnProblem_;
+  int motorFlagsRetarget_;      /* MF_RETARGET, bit 2 is kept for MF_SHOW_NOT_HOMED */
 
   // These are per-axis parameters for passing additional motor record information to the driver
   int motorRecResolution_;
@@ -340,7 +434,9 @@ class epicsShareClass asynAxisController : public asynPortDriver {
   int motorDefJogAccRO_;
   int motorSDBDRO_;
   int motorRDBDRO_;
-  // These are the per-controller parameters for profile moves
+  // These are the per-controller parameters for profile moves.
+  // They only exist in the parameter list of address 0, keep them together
+  #define FIRST_MOTOR_CONTROLLER_PARAM profileNumAxes_
   int profileNumAxes_;
   int profileNumPoints_;
   int profileCurrentPoint_;
@@ -367,6 +463,7 @@ class epicsShareClass asynAxisController : public asynPortDriver {
   int profileReadbackState_;
   int profileReadbackStatus_;
   int profileReadbackMessage_;
+  #define LAST_MOTOR_CONTROLLER_PARAM profileReadbackMessage_
 
   // These are the per-axis parameters for profile moves
   int profileUseAxis_;
@@ -382,12 +479,27 @@ class epicsShareClass asynAxisController : public asynPortDriver {
   double idlePollPeriod_;       /**< The time between polls when no axes are moving */
   double movingPollPeriod_;     /**< The time between polls when any axis is moving */
   int    forcedFastPolls_;      /**< The number of forced fast polls when the poller wakes up */
+  double estimatePeriod_;       /**< The time between estimated positions, 0 = off */
+  int stopsPending_;            /**< Stops waiting for the port lock, the poller lets them in */
+  int pollerStarted_;           /**< startPoller() has been called */
+  int latencyTrace_;            /**< Time the stages of moves, see MOTOR_LATENCY_TRACE */
+  unsigned long latencyHistogram_[MOTOR_LATENCY_STAGES][MOTOR_LATENCY_BINS];
+  void addLatency(int stage, double latency);
+  int waitForNextPoll(double timeout, bool anyMoving);
  
   size_t maxProfilePoints_;     /**< Maximum number of profile points */
   double *profileTimes_;        /**< Array of times per profile point */
 
   int moveToHomeAxis_;
 
+  void pollUnpolledAxes();
+  asynAxisController *nextController_;  /**< List of all controllers, see findController() */
+  static asynAxisController *controllerList_;
+  int controllerParamsCreated_;  /**< The per-controller parameters exist in list 0 */
+  void createParamNames();
+  MotorParamName *paramNames_;   /**< The motor parameters sorted by name */
+  int numParamNames_;
+
   /* These are convenience functions for controllers that use asynOctet interfaces to the hardware */
   asynStatus writeController();
   asynStatus writeController(const char *output, double timeout);
@@ -401,6 +513,7 @@ class epicsShareClass asynAxisController : public asynPortDriver {
   friend class asynAxisAxis;
 };
 #define NUM_MOTOR_DRIVER_PARAMS (&LAST_MOTOR_PARAM - &FIRST_MOTOR_PARAM + 1)
+#define NUM_MOTOR_CONTROLLER_PARAMS (&LAST_MOTOR_CONTROLLER_PARAM - &FIRST_MOTOR_CONTROLLER_PARAM + 1)
 
 #endif /* _cplusplus */
 #endif /* asynAxisController_H */
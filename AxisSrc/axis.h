@@ -111,7 +111,10 @@ typedef enum  {
         PRIMITIVE,      /* Primitive Controller command. */
         SET_HIGH_LIMIT, /* Set High Travel Limit. */
         SET_LOW_LIMIT,  /* Set Low Travel Limit. */
-        JOG_VELOCITY    /* Change Jog velocity. */
+        JOG_VELOCITY,   /* Change Jog velocity. */
+        SET_BACKLASH,   /* Backlash approach after the move of this transaction. */
+        SET_RETRY,      /* Retries of the move of this transaction. */
+        RETARGET        /* New target of the move in progress. */
 } motor_cmnd;
 
 
@@ -157,7 +160,8 @@ typedef union
     struct
     {
 #ifdef MSB_First
-        unsigned int na             :17;/* N/A bits  */
+        unsigned int na             :16;/* N/A bits  */
+        unsigned int RA_ESTIMATED   :1; /* Positions are estimated between polls */
         unsigned int RA_HOMED       :1; /* Axis has been homed.*/
         unsigned int RA_MINUS_LS    :1; /* minus limit switch has been hit */
         unsigned int CNTRL_COMM_ERR :1; /* Controller communication error. */
@@ -189,7 +193,8 @@ typedef union
         unsigned int CNTRL_COMM_ERR :1; /* Controller communication error. */
         unsigned int RA_MINUS_LS    :1; /* minus limit switch has been hit */
         unsigned int RA_HOMED       :1; /* Axis has been homed.*/
-        unsigned int na             :17;/* N/A bits  */
+        unsigned int RA_ESTIMATED   :1; /* Positions are estimated between polls */
+        unsigned int na             :16;/* N/A bits  */
 #endif
     } Bits;                                
 } msta_field;
@@ -206,6 +211,7 @@ typedef union
 #define MF_HOME_ON_LS      (1)
 #define MF_STOP_PROB       (1<<1)
 /*#define MF_SHOW_NOT_HOMED       (1<<2) not use in record */
+#define MF_RETARGET        (1<<3) /* RETARGET is supported */
 
 
 /* device support entry table */
@@ -39,6 +39,13 @@ calls.
   Calls to device support
   Wrappers that call device support.
 *****************************************************************************/
+CALLBACK_VALUE devSupUpdateValues(axisRecord *pmr)
+{
+    struct motor_dset *pdset = (struct motor_dset *) (pmr->dset);
+    return (*pdset->update_values) (pmr);
+}
+
+/******************************************************************************/
 void devSupStop(axisRecord *pmr)
 {
     struct motor_dset *pdset = (struct motor_dset *) (pmr->dset);
@@ -96,12 +103,58 @@ RTN_STATUS devSupUpdateLimitFromDial(axisRecord *pmr, motor_cmnd command,
     return status;
 }
 
+/*****************************************************************************/
+/* Hand the retries of the move in this transaction to device support.
+   Must come before the move, retry may be NULL */
+static void writeRetry(axisRecord *pmr, devSupRetry *retry)
+{
+    struct motor_dset *pdset = (struct motor_dset *) (pmr->dset);
+
+    if (retry)
+        retry->taken = (WRITE_MSG(SET_RETRY, retry->param) == OK);
+}
+
+/*****************************************************************************/
+/* Move to pos and take out the backlash to bpos, with bvel and bacc, in one
+   transaction.  relative: pos is relative to the current position and bpos
+   to pos.  Returns ERROR, without moving, if device support can't do it. */
+RTN_STATUS devSupMoveBacklashRaw(axisRecord *pmr, double vel, double vbase,
+                                 double acc, double pos, double bvel,
+                                 double bacc, double bpos, int relative,
+                                 devSupRetry *retry)
+{
+    struct motor_dset *pdset = (struct motor_dset *) (pmr->dset);
+    double backlash[3];
+
+    backlash[0] = bpos;
+    backlash[1] = bvel;
+    backlash[2] = bacc;
+    INIT_MSG();
+    if (WRITE_MSG(SET_BACKLASH, backlash) != OK)
+    {
+        SEND_MSG();
+        return ERROR;
+    }
+    writeRetry(pmr, retry);
+    if (vel <= vbase)
+        vel = vbase + 1;
+    WRITE_MSG(SET_VELOCITY, &vel);
+    WRITE_MSG(SET_VEL_BASE, &vbase);
+    if (acc > 0.0)  /* Don't SET_ACCEL if vel = vbase. */
+        WRITE_MSG(SET_ACCEL, &acc);
+    WRITE_MSG(relative ? MOVE_REL : MOVE_ABS, &pos);
+    WRITE_MSG(GO, NULL);
+    SEND_MSG();
+    return OK;
+}
+
 /*****************************************************************************/
 void devSupMoveAbsRaw(axisRecord *pmr, double vel, double vbase,
-                      double acc, double pos)
+                      double acc, double pos, devSupRetry *retry)
 {
     struct motor_dset *pdset = (struct motor_dset *) (pmr->dset);
     INIT_MSG();
+    writeRetry(pmr, retry);
     if (vel <= vbase)
         vel = vbase + 1;
     WRITE_MSG(SET_VELOCITY, &vel);
@@ -118,10 +171,11 @@ void devSupMoveAbsRaw(axisRecord *pmr, double vel, double vbase,
 
 /*****************************************************************************/
 void devSupMoveRelRaw(axisRecord *pmr, double vel, double vbase,
-                      double acc, double relpos)
+                      double acc, double relpos, devSupRetry *retry)
 {
     struct motor_dset *pdset = (struct motor_dset *) (pmr->dset);
     INIT_MSG();
+    writeRetry(pmr, retry);
     if (vel <= vbase)
         vel = vbase + 1;
     WRITE_MSG(SET_VELOCITY, &vel);
@@ -135,6 +189,22 @@ void devSupMoveRelRaw(axisRecord *pmr, double vel, double vbase,
 /* No WRITE_MSG(MOVE_REL, ); after this point */
 #define MOVE_REL #ErrorMOVE_REL
 
+/*****************************************************************************/
+/* Change the target of the move in progress to pos, without stopping.
+   Returns ERROR, without changing anything, if device support can't do it. */
+RTN_STATUS devSupRetargetRaw(axisRecord *pmr, double pos)
+{
+    struct motor_dset *pdset = (struct motor_dset *) (pmr->dset);
+    RTN_STATUS status;
+
+    INIT_MSG();
+    status = WRITE_MSG(RETARGET, &pos);
+    SEND_MSG();
+    return status;
+}
+/* No WRITE_MSG(RETARGET, ); after this point */
+#define RETARGET #ErrorRETARGET
+
 /*****************************************************************************/
 void devSupJogDial(axisRecord *pmr, double jogv, double jacc)
 {
@@ -38,15 +38,27 @@ fields.  ('pmr' is a pointer to axisRecord.)
 #define MIP_EXTERNAL    0x8000  /* Move started by external source */
 
 
+/* Retries of a move done by device support, see SET_RETRY */
+typedef struct {
+    double param[4];    /* Deadband (steps), count, fraction, 1 to use the encoder */
+    int taken;          /* Set by devSupMove*Raw(): device support does the retries */
+} devSupRetry;
+
+  CALLBACK_VALUE devSupUpdateValues(axisRecord *pmr);
   void devSupStop(axisRecord *pmr);
   void devSupLoadPos(axisRecord *pmr, double newpos);
   RTN_STATUS devSupGetInfo(axisRecord *pmr);
   RTN_STATUS devSupUpdateLimitFromDial(axisRecord *pmr, motor_cmnd command,
                                        double dialValue);
   void devSupMoveAbsRaw(axisRecord *pmr, double vel, double vbase,
-                        double acc, double pos);
+                        double acc, double pos, devSupRetry *retry);
   void devSupMoveRelRaw(axisRecord *pmr, double vel, double vbase,
-                        double acc, double relpos);
+                        double acc, double relpos, devSupRetry *retry);
+  RTN_STATUS devSupMoveBacklashRaw(axisRecord *pmr, double vel, double vbase,
+                                   double acc, double pos, double bvel,
+                                   double bacc, double bpos, int relative,
+                                   devSupRetry *retry);
+  RTN_STATUS devSupRetargetRaw(axisRecord *pmr, double pos);
   void devSupJogDial(axisRecord *pmr, double jogv, double jacc);
   void devSupUpdateJogRaw(axisRecord *pmr, double jogv, double jacc);
   void devSupCNEN(axisRecord *pmr, double cnen);
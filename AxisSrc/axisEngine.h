@@ -0,0 +1,44 @@
+/*
+FILENAME...     axisEngine.h
+USAGE...        Motion logic of the axis record.
+
+*/
+
+/*****************************************************************************
+  The motion state machine of the axis record: process(), special() and
+  the part of init_record() after the device support entry table has been
+  checked.  axisRecord.cc is the record support glue around it.
+
+  The engine only sees the record fields, device support through
+  axisDevSup.h and the IOC through axisRecIoc.h.  Linked against other
+  implementations of those it runs without an IOC, see AxisTest.
+
+  One engine per record, created by init_record() and kept in pmr->cbak.
+*****************************************************************************/
+#ifndef INC_axisEngine_H
+#define INC_axisEngine_H
+
+#include <callback.h>
+#include "axisRecord.h"
+#include "axis.h"
+
+class axisEngine
+{
+public:
+    axisEngine(axisRecord *pmr);
+    void init();                /* Before the init_record() of device support */
+    long initialPoll();         /* After it */
+    long process();
+    long special(int fieldIndex, int after);
+
+    /* Timers of the record */
+    CALLBACK dly_callback;      /* DLY after the end of a move */
+    CALLBACK settle_callback;   /* STIM after the readback last left SWIN */
+    CALLBACK coalesce_callback; /* Take up a target held back by CINT */
+    CALLBACK flush_callback;    /* Post the readbacks held back by MRAT */
+
+private:
+    axisRecord *pmr;
+};
+
+#endif /* INC_axisEngine_H */
@@ -0,0 +1,191 @@
+#include    <alarm.h>
+#include    <dbAccess.h>
+#include    <dbCa.h>
+#include    <dbEvent.h>
+#include    <recGbl.h>
+#include    <callback.h>
+#include    <dbScan.h>
+#include    <epicsVersion.h>
+#include    "axis_priv.h"
+#include    "axisRecord.h"
+#include    "axis.h"
+#include    "axisRecIoc.h"
+
+/*****************************************************************************
+  Calls to the IOC
+  Wrappers for the database calls of the motion logic.
+*****************************************************************************/
+void recIocPostEvents(axisRecord *pmr, void *pfield, unsigned int mask)
+{
+    db_post_events(pmr, pfield, mask);
+}
+
+/******************************************************************************/
+unsigned short recIocResetAlarms(axisRecord *pmr)
+{
+    return recGblResetAlarms(pmr);
+}
+
+/******************************************************************************/
+void recIocSetSevr(axisRecord *pmr, epicsEnum16 stat, epicsEnum16 sevr)
+{
+    recGblSetSevr((dbCommon *) pmr, stat, sevr);
+}
+
+/******************************************************************************/
+long recIocGetLink(axisRecord *pmr, DBLINK *plink, double *pvalue)
+{
+    return dbGetLink(plink, DBR_DOUBLE, pvalue, 0, 0);
+}
+
+/******************************************************************************/
+long recIocPutLink(axisRecord *pmr, DBLINK *plink, double *pvalue)
+{
+    return dbPutLink(plink, DBR_DOUBLE, pvalue, 1);
+}
+
+/* dbCaRemoveLink() got a dbLocker argument in base 3.16 */
+#if (EPICS_VERSION == 3) && (EPICS_REVISION <= 15)
+#define rdblRemoveLink(plink) dbCaRemoveLink(plink)
+#else
+#define rdblRemoveLink(plink) dbCaRemoveLink(NULL, plink)
+#endif
+
+/******************************************************************************/
+/* Monitor callback of the RDBL CA link, from the dbCa task */
+static void rdblMonitor(void *userPvt)
+{
+    axisRecord *pmr = (axisRecord *) userPvt;
+    epicsEnum16 sevr = NO_ALARM;
+    double value;
+
+    if (dbCaGetLink(&pmr->rdbl, DBR_DOUBLE, &value, NULL, &sevr, NULL))
+        return;
+    epicsMutexMustLock(pmr->priv->rdbl.lock);
+    pmr->priv->rdbl.value = value;
+    pmr->priv->rdbl.sevr = sevr;
+    epicsTimeGetCurrent(&pmr->priv->rdbl.time);
+    pmr->priv->rdbl.valid = 1;
+    epicsMutexUnlock(pmr->priv->rdbl.lock);
+}
+
+/******************************************************************************/
+/* Connection callback of the RDBL CA link: forget the value on disconnect */
+static void rdblConnect(void *userPvt)
+{
+    axisRecord *pmr = (axisRecord *) userPvt;
+
+    if (dbCaIsLinkConnected(&pmr->rdbl))
+        return;
+    epicsMutexMustLock(pmr->priv->rdbl.lock);
+    pmr->priv->rdbl.valid = 0;
+    epicsMutexUnlock(pmr->priv->rdbl.lock);
+}
+
+/******************************************************************************/
+/* Subscribe to RDBL if it is a CA link, so that recIocGetReadback() reads
+   the latest value without waiting for the link.  Other links are read by
+   recIocGetReadback() as before.  Called again when RDBL was changed. */
+void recIocMonitorReadback(axisRecord *pmr)
+{
+    if (pmr->priv->rdbl.lock)
+    {
+        /* Forget the value of the old link */
+        epicsMutexMustLock(pmr->priv->rdbl.lock);
+        pmr->priv->rdbl.valid = 0;
+        epicsMutexUnlock(pmr->priv->rdbl.lock);
+    }
+    if (pmr->rdbl.type != CA_LINK)
+        return;
+    if (!pmr->priv->rdbl.lock)
+        pmr->priv->rdbl.lock = epicsMutexMustCreate();
+    rdblRemoveLink(&pmr->rdbl);
+    dbCaAddLinkCallback(&pmr->rdbl, rdblConnect, rdblMonitor, pmr);
+}
+
+/******************************************************************************/
+/* Read RDBL, from the cache of recIocMonitorReadback() if there is one.
+   A cached value older than maxAge seconds (if maxAge > 0) is not used. */
+long recIocGetReadback(axisRecord *pmr, double maxAge, double *pvalue)
+{
+    struct axis_priv *priv = pmr->priv;
+    epicsTimeStamp now, time;
+    epicsEnum16 sevr;
+    double value;
+    int valid;
+
+    if (!priv->rdbl.lock)
+        return recIocGetLink(pmr, &pmr->rdbl, pvalue);
+
+    epicsMutexMustLock(priv->rdbl.lock);
+    valid = priv->rdbl.valid;
+    value = priv->rdbl.value;
+    sevr = priv->rdbl.sevr;
+    time = priv->rdbl.time;
+    epicsMutexUnlock(priv->rdbl.lock);
+
+    /* Not connected yet, or not any more: the link has the alarm */
+    if (!valid)
+        return recIocGetLink(pmr, &pmr->rdbl, pvalue);
+    if (maxAge > 0.0)
+    {
+        epicsTimeGetCurrent(&now);
+        if (epicsTimeDiffInSeconds(&now, &time) > maxAge)
+        {
+            recGblSetSevr((dbCommon *) pmr, READ_ALARM, INVALID_ALARM);
+            return -1;
+        }
+    }
+    if ((pmr->rdbl.value.pv_link.pvlMask & pvlOptMS) && sevr)
+        recGblSetSevr((dbCommon *) pmr, LINK_ALARM, sevr);
+    *pvalue = value;
+    return 0;
+}
+
+/******************************************************************************/
+void recIocRequestDelay(axisRecord *pmr, CALLBACK *pcallback, double delay)
+{
+    callbackRequestDelayed(pcallback, delay);
+}
+
+/******************************************************************************/
+void recIocScanOnce(axisRecord *pmr)
+{
+#if LT_EPICSBASE(3,14,10)
+    scanOnce(pmr);
+#else
+    scanOnce((struct dbCommon *) pmr);
+#endif
+}
+
+/******************************************************************************/
+/* The clock of the timers above */
+void recIocGetCurrentTime(axisRecord *pmr, epicsTimeStamp *pnow)
+{
+    epicsTimeGetCurrent(pnow);
+}
+
+/******************************************************************************/
+void recIocGetTimeStamp(axisRecord *pmr)
+{
+    recGblGetTimeStamp(pmr);
+}
+
+/******************************************************************************/
+void recIocFwdLink(axisRecord *pmr)
+{
+    recGblFwdLink(pmr);
+}
+
+/******************************************************************************/
+/* For callbacks that touch the record without processing it */
+void recIocLock(axisRecord *pmr)
+{
+    dbScanLock((dbCommon *) pmr);
+}
+
+/******************************************************************************/
+void recIocUnlock(axisRecord *pmr)
+{
+    dbScanUnlock((dbCommon *) pmr);
+}
@@ -0,0 +1,36 @@
+/*****************************************************************************
+  Calls to the IOC
+  Wrappers for the database calls of the motion logic in axisEngine.cc.
+  Together with axisDevSup.h they are everything the motion logic needs
+  outside the record, so that it can be linked against other
+  implementations, e.g. to run it without an IOC.
+*****************************************************************************/
+#ifndef INC_axisRecIoc_H
+#define INC_axisRecIoc_H
+
+#include <callback.h>
+#include <epicsTime.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+  void recIocPostEvents(axisRecord *pmr, void *pfield, unsigned int mask);
+  unsigned short recIocResetAlarms(axisRecord *pmr);
+  void recIocSetSevr(axisRecord *pmr, epicsEnum16 stat, epicsEnum16 sevr);
+  long recIocGetLink(axisRecord *pmr, DBLINK *plink, double *pvalue);
+  long recIocPutLink(axisRecord *pmr, DBLINK *plink, double *pvalue);
+  void recIocMonitorReadback(axisRecord *pmr);
+  long recIocGetReadback(axisRecord *pmr, double maxAge, double *pvalue);
+  void recIocRequestDelay(axisRecord *pmr, CALLBACK *pcallback, double delay);
+  void recIocScanOnce(axisRecord *pmr);
+  void recIocGetCurrentTime(axisRecord *pmr, epicsTimeStamp *pnow);
+  void recIocGetTimeStamp(axisRecord *pmr);
+  void recIocFwdLink(axisRecord *pmr);
+  void recIocLock(axisRecord *pmr);
+  void recIocUnlock(axisRecord *pmr);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /* INC_axisRecIoc_H */
@@ -200,6 +200,43 @@ for this is pretty unclear to me (I suspect it could be).
 \li It is \b not called in the second invocation (lines 778-798).
 \li It is  included in the third invocation (lines 2042-2102).
 
+\subsubsection ss5a Move sequence with backlash approach.
+\li \b SET_BACKLASH
+\li \b SET_VEL_BASE
+\li \b SET_VELOCITY
+\li ( \b SET_ACCEL )
+\li \b MOVE_REL or \b MOVE_ABS
+\li \b GO
+
+Sent by devSupMoveBacklashRaw() in axisDevSup.c. The parameter of
+\b SET_BACKLASH is an array of three: the final position (relative to the
+end of the move for \b MOVE_REL), the backlash velocity and the backlash
+acceleration, all raw. The device support runs the move and the approach
+back to back and reports done only at the end of the approach. Device
+support that can't do this returns ERROR for \b SET_BACKLASH, which is the
+first command of the transaction, and the record then does the approach
+as a move of its own.
+
+\subsubsection ss5b Retries in device support.
+
+With RDRV set, the record puts \b SET_RETRY in front of the last move to
+the target, see devSupRetry in axisDevSup.h. Its parameter is an array of
+four: the retry deadband in steps, the retry count, the move fraction and
+1 if the readback is the encoder. Device support that accepts it corrects
+the position until it is within the deadband or out of retries, and only
+then reports done. If it returns ERROR, the move is sent anyway and the
+record does the retries.
+
+\subsubsection ss5c New target while moving.
+\li \b RETARGET
+
+Sent by devSupRetargetRaw() in axisDevSup.c when DVAL changes during a
+single move to the target. The parameter is the new raw position, the
+move keeps its velocity and acceleration and is not stopped. Device
+support that can't do it, or whose driver doesn't set MF_RETARGET in the
+flags, returns ERROR, and the record moves to the new target after the
+move is done.
+
 \subsubsection ss6 Jog sequences
 
 There are two jog sequences:
@@ -4,6 +4,8 @@
 #define INC_axis_priv_H
 
 #include "epicsTypes.h"
+#include "epicsTime.h"
+#include "epicsMutex.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -37,8 +39,27 @@ extern "C" {
       double rlv;                /* Last Rel Value (EGU) */
       double alst;               /* Last Value Archived */
       double mlst;               /* Last Val Monitored */
+      double drbv;               /* Last .DRBV posted */
+      epicsInt32 rrbv;           /* Last .RRBV posted */
+      epicsUInt32 msta;          /* Last .MSTA posted */
+      epicsTimeStamp postTime;   /* Last post of the readbacks, for MRAT */
+      epicsUInt32 heldBack;      /* Readbacks held back by MRAT, as in mmap */
       short  dmov;               /* last .DMOV */
     } last;
+    int retriesInDriver;         /* The latest move was sent with SET_RETRY, see RDRV */
+    double settlePosition;       /* DRBV when STIM was last started, see SWIN */
+    struct {
+      epicsTimeStamp sent;       /* The latest move or new target was sent */
+      int pending;               /* and device support has not reported back yet */
+      int held;                  /* A new target waits for the CINT timer */
+    } coalesce;
+    struct {
+      epicsMutexId lock;         /* NULL: RDBL is not cached, read it with dbGetLink() */
+      double value;              /* Latest value from the RDBL monitor */
+      epicsEnum16 sevr;          /* and its severity */
+      epicsTimeStamp time;       /* When it arrived */
+      int valid;                 /* A value has arrived */
+    } rdbl;
   };
   
 #ifdef __cplusplus
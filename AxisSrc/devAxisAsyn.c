@@ -43,6 +43,53 @@
  * Added "Use Relative" (use_rel) indicator to init_controller()'s "LOAD_POS" logic.
  * See README R6-10 item #6 for details.
  * 
+ * .07 Each record owns a small pool of pre-built asynUser/message pairs, used
+ * by build_trans(); the allocator is only a counted fallback.
+ * The pool usage is shown by dbior("devMotorAsyn").
+ * 
+ * .08 start_trans()/end_trans() bracket a real transaction: the motion
+ * settings and the move are collected by build_trans() and sent by
+ * end_trans() as one MOTOR_MOVE_COMPOUND request.
+ * 
+ * .09 Optional group commit of moves: devMotorAsynGroupMoves(port, window)
+ * collects the moves for a port that arrive within window seconds and sends
+ * them as one batch between setDeferredMoves(true) and setDeferredMoves(false).
+ * 
+ * .10 statusCallback() only stores the latest status, the record is processed
+ * from the callback queue.  Statuses that arrive before that are merged.
+ * 
+ * .11 config_controller() asks for MOTOR_UPDATE_STATUS_INIT, so that the
+ * controller is polled once for all its records during iocInit.
+ * 
+ * .12 The driver reasons are looked up for the first record of a port and
+ * shared with the other records of that port.
+ * 
+ * .13 STOP_AXIS is queued with high priority and announced to the driver
+ * first, see asynAxisControllerStopBegin().  The stop latency is shown as a
+ * histogram per port by dbior("devMotorAsyn").
+ * 
+ * .14 Optional latency tracing of moves: devMotorAsynLatencyTrace(port, enable)
+ * times each move from build_trans() to the status with DONE, per record and
+ * per port, and switches on the stages of the driver, see MOTOR_LATENCY_TRACE.
+ * 
+ * .15 SET_BACKLASH adds the backlash approach to the MOTOR_MOVE_COMPOUND of the
+ * transaction.  Without compound moves it returns ERROR, and the record does
+ * the approach as a move of its own.
+ * 
+ * .16 SET_RETRY adds the retries of the record (deadband, count, fraction and
+ * use encoder) to the MOTOR_MOVE_COMPOUND of the transaction, so that the driver
+ * does the corrections.  Without compound moves it returns ERROR.
+ * 
+ * .17 RETARGET sends a new target for the move in progress to MOTOR_RETARGET.
+ * It returns ERROR unless the driver has it and sets MF_RETARGET.
+ * 
+ * .18 A STOP_AXIS cancels the moves of the record that wait for a group batch,
+ * and asynCallback() drops the moves that were queued before the stop.
+ * 
+ * .19 init_record() no longer waits for the LOAD_POS of the saved position.
+ * The positions of all records of a port are restored by one request, queued
+ * by init(1), and the ports restore theirs in parallel, see defer_load_pos().
+ * 
  */
 
 #include <stddef.h>
@@ -58,8 +105,14 @@
 #include <devSup.h>
 #include <alarm.h>
 #include <epicsEvent.h>
+#include <epicsMutex.h>
+#include <epicsAtomic.h>
+#include <ellLib.h>
+#include <epicsString.h>
 #include <cantProceed.h> /* !! for callocMustSucceed() */
 #include <dbEvent.h>
+#include <callback.h>
+#include <iocsh.h>
 
 #include <asynDriver.h>
 #include <asynInt32.h>
@@ -77,6 +130,7 @@
 #include "axis_interface.h"
 
 /*Create the dset for devMotor */
+static long report( int level );
 static long init( int after );
 static long init_record(struct axisRecord *);
 static CALLBACK_VALUE update_values(struct axisRecord *);
@@ -85,13 +139,17 @@ static RTN_STATUS build_trans( motor_cmnd, double *, struct axisRecord *);
 static RTN_STATUS end_trans(struct axisRecord *);
 static void asynCallback(asynUser *);
 static void statusCallback(void *, asynUser *, void *);
+static void statusCallbackProcess(CALLBACK *);
+static void groupTimerCallback(CALLBACK *);
+static void groupCallback(asynUser *);
+static void restoreCallback(asynUser *);
 
-typedef enum {int32Type, float64Type, float64ArrayType} interfaceType;
+typedef enum {int32Type, float64Type, float64ArrayType, genericPointerType} interfaceType;
 
 struct motor_dset devMotorAsyn={ 
     {
          8,
-         NULL,
+         (DEVSUPFUN) report,
          (DEVSUPFUN) init,
          (DEVSUPFUN) init_record,
          NULL 
@@ -128,24 +186,110 @@ typedef enum motorCommand {
     motorSetClosedLoop,
     motorStatus,
     motorUpdateStatus,
+    motorMoveCompound,
+    motorRetarget,
     lastMotorCommand
 } motorCommand;
 #define NUM_MOTOR_COMMANDS lastMotorCommand
 
 typedef struct {
+    ELLNODE node;       /* Must be first, list of grouped moves */
+    asynUser *pasynUser; /* The request this message belongs to */
     motorCommand command;
     interfaceType interface;
     int ivalue;
     double dvalue;
+    MotorMoveCompound move;
+    int poolIndex;      /* Index into motorAsynPvt.pool, -1 if allocated */
+    int stopAnnounced;  /* 1: stop announced to the driver, 2: and sent by fastStop() */
+    epicsTimeStamp stopTime; /* When build_trans() got the stop */
+    int traced;         /* A move timed by the latency trace */
+    epicsTimeStamp traceTime; /* When build_trans() or end_trans() got the move */
+    int stopGeneration; /* motorAsynPvt.stopGeneration when the request was built */
 } motorAsynMessage;
 
+/* Number of pre-built requests per record.
+   A move is one request, but without MOTOR_MOVE_COMPOUND devSupMoveAbsRaw()
+   needs 4 (SET_VELOCITY, SET_VEL_BASE, SET_ACCEL, GO) */
+#define MOTOR_ASYN_POOL_SIZE 8
+
+typedef struct {
+    asynUser *pasynUser;
+    motorAsynMessage msg;
+    int inUse;
+} motorAsynRequest;
+
+/* Stop latency histogram, the upper limits of the bins in seconds */
+static const double stopLatencyLimits[] = {1e-4, 1e-3, 1e-2, 1e-1, 1.};
+#define MOTOR_ASYN_STOP_BINS (NELEMENTS(stopLatencyLimits) + 1)
+
+/* Stages of a move timed by the latency trace */
+typedef enum {
+    traceQueue,         /* build_trans() to asynCallback(), includes the group window */
+    traceWrite,         /* The write to the driver, includes move() */
+    traceDone,          /* End of the write to the status with DONE */
+    traceDeliver,       /* statusCallback() to statusCallbackProcess(), every status */
+    traceTotal,         /* build_trans() to the status with DONE */
+    lastTraceStage
+} traceStage;
+#define NUM_TRACE_STAGES lastTraceStage
+static const char * const traceStageNames[NUM_TRACE_STAGES] =
+    {"queue", "write", "done", "deliver", "total"};
+
+/* Latency trace histogram, the upper limits of the bins in seconds */
+static const double traceLatencyLimits[] = {1e-4, 1e-3, 1e-2, 1e-1, 1., 10., 100.};
+#define MOTOR_ASYN_TRACE_BINS (NELEMENTS(traceLatencyLimits) + 1)
+
+/* Per port state, shared by the records of a port */
 typedef struct
 {
+    ELLNODE node;       /* Must be first, list of all ports */
+    char *portName;
+    int reasonsValid;   /* driverReasons[] are looked up */
+    int driverReasons[NUM_MOTOR_COMMANDS];
+    int compoundSupported;
+    int retargetSupported;
+    void *pController;  /* The asynAxisController, for stops */
+    unsigned long stopLatency[MOTOR_ASYN_STOP_BINS];
+    int trace;          /* Latency trace of moves */
+    unsigned long traceLatency[NUM_TRACE_STAGES][MOTOR_ASYN_TRACE_BINS];
+    double window;      /* Time to collect moves, 0 = don't group, under lock */
+    epicsMutexId lock;
+    ELLLIST pending;    /* Moves waiting for the next batch */
+    int batchQueued;    /* The timer is running or the batch is queued */
+    CALLBACK timer;
+    asynUser *pasynUser;
+    asynInt32 *pasynInt32;
+    void *asynInt32Pvt;
+    int deferMovesReason; /* -1 if the driver can't defer moves */
+    unsigned long batches;
+    unsigned long batchedMoves;
+    int maxBatch;
+    int initRecords;    /* Records of the port that init_record() has seen */
+    double initTime;    /* The time they took, sec */
+    ELLLIST restores;   /* LOAD_POS of init_record(), sent by restoreCallback() */
+    asynUser *pasynUserRestore;
+    int restoredPositions;
+    double restoreTime; /* The time restoreCallback() took, sec */
+} motorAsynPort;
+
+static ELLLIST motorAsynPortList = ELLLIST_INIT;
+
+typedef struct
+{
+    ELLNODE node;       /* Must be first, list of all records for report() */
     struct axisRecord * pmr;
+    int axis;
     int moveRequestPending;
+    int stopGeneration;      /* Counts the stops, moves built before the latest are dropped */
     struct MotorStatus status;
     motorCommand move_cmd;
     double param;
+    int compoundSupported;   /* The driver knows MOTOR_MOVE_COMPOUND */
+    int retargetSupported;   /* The driver knows MOTOR_RETARGET */
+    int transActive;         /* Between start_trans() and end_trans() */
+    motorCommand transMove;  /* The move collected in the transaction, or -1 */
+    MotorMoveCompound trans; /* Settings and value of the transaction */
     int needUpdate;
     asynUser *pasynUser;
     asynInt32 *pasynInt32;
@@ -161,18 +305,461 @@ typedef struct
     void *registrarPvt;
     epicsEventId initEvent;
     int driverReasons[NUM_MOTOR_COMMANDS];
+    epicsMutexId poolLock;
+    motorAsynRequest pool[MOTOR_ASYN_POOL_SIZE];
+    int poolInUse;
+    int poolHighWater;
+    unsigned long poolFallbacks;
+    motorAsynPort *pPort;
+    epicsMutexId statusLock;
+    struct MotorStatus latestStatus; /* Written by statusCallback() */
+    int statusNew;          /* latestStatus is not copied to status yet */
+    int statusQueued;       /* statusCallbackProcess() is queued */
+    CALLBACK statusCb;
+    unsigned long statusMerged;
+    int restorePending;     /* A LOAD_POS of init_record() waits for restoreCallback() */
+    epicsTimeStamp latestStatusTime; /* When statusCallback() queued, latency trace only */
+    int traceActive;         /* A traced move waits for DONE */
+    epicsTimeStamp traceStart;   /* When build_trans() got the traced move */
+    epicsTimeStamp traceWritten; /* When the driver returned from the traced move */
+    unsigned long traceLatency[NUM_TRACE_STAGES][MOTOR_ASYN_TRACE_BINS];
 } motorAsynPvt;
 
+static ELLLIST motorAsynPvtList = ELLLIST_INIT;
+
+static void take_latest_status(motorAsynPvt *);
+static void drop_restores(motorAsynPort *);
+
 
 
-/* The init routine is used to set a flag to indicate that it is OK to call dbScanLock */
+/* The init routine is used to set a flag to indicate that it is OK to call dbScanLock.
+ * After init_record() it queues the positions to restore, one request per port */
 static int dbScanLockOK = 0;
 static long init( int after )
 {
+    motorAsynPort *pPort;
+
     dbScanLockOK = (after!=0);
+    if (!after)
+        return 0;
+    for (pPort = (motorAsynPort *)ellFirst(&motorAsynPortList); pPort;
+         pPort = (motorAsynPort *)ellNext(&pPort->node)) {
+        if (!ellCount(&pPort->restores))
+            continue;
+        if (pasynManager->queueRequest(pPort->pasynUserRestore,
+                                       asynQueuePriorityMedium, 0) != asynSuccess) {
+            asynPrint(pPort->pasynUserRestore, ASYN_TRACE_ERROR,
+                      "devMotorAsyn::init: port %s error calling queueRequest, %s\n",
+                      pPort->portName, pPort->pasynUserRestore->errorMessage);
+            drop_restores(pPort);
+        }
+    }
     return 0;
 }
 
+/* Print the latency trace histograms of a port or a record */
+static void report_trace(const char *name, unsigned long latency[][MOTOR_ASYN_TRACE_BINS])
+{
+    int stage;
+    size_t i;
+
+    for (stage = 0; stage < NUM_TRACE_STAGES; stage++) {
+        printf("    %s %-7s", name, traceStageNames[stage]);
+        for (i = 0; i < MOTOR_ASYN_TRACE_BINS - 1; i++)
+            printf(" <%gs:%lu", traceLatencyLimits[i], latency[stage][i]);
+        printf(" more:%lu\n", latency[stage][i]);
+    }
+}
+
+static long report( int level )
+{
+    motorAsynPvt *pPvt;
+    motorAsynPort *pPort;
+
+    for (pPort = (motorAsynPort *)ellFirst(&motorAsynPortList); pPort;
+         pPort = (motorAsynPort *)ellNext(&pPort->node)) {
+        unsigned long stops = 0;
+        double window;
+        size_t i;
+
+        if (pPort->initRecords)
+            printf("    port %s init records=%d time=%.3fs (%.3fms per record)\n",
+                   pPort->portName, pPort->initRecords, pPort->initTime,
+                   1e3 * pPort->initTime / pPort->initRecords);
+        if (pPort->restoredPositions)
+            printf("    port %s restored positions=%d time=%.3fs\n",
+                   pPort->portName, pPort->restoredPositions, pPort->restoreTime);
+        epicsMutexMustLock(pPort->lock);
+        window = pPort->window;
+        epicsMutexUnlock(pPort->lock);
+        if (window > 0.)
+            printf("    port %s group window=%g batches=%lu moves=%lu maxBatch=%d\n",
+                   pPort->portName, window, pPort->batches,
+                   pPort->batchedMoves, pPort->maxBatch);
+        if (pPort->trace)
+            report_trace(pPort->portName, pPort->traceLatency);
+        for (i = 0; i < MOTOR_ASYN_STOP_BINS; i++)
+            stops += pPort->stopLatency[i];
+        if (!stops) continue;
+        printf("    port %s stop latency", pPort->portName);
+        for (i = 0; i < MOTOR_ASYN_STOP_BINS - 1; i++)
+            printf(" <%gs:%lu", stopLatencyLimits[i], pPort->stopLatency[i]);
+        printf(" more:%lu\n", pPort->stopLatency[i]);
+    }
+
+    for (pPvt = (motorAsynPvt *)ellFirst(&motorAsynPvtList); pPvt;
+         pPvt = (motorAsynPvt *)ellNext(&pPvt->node)) {
+        if (level < 1 && !pPvt->poolFallbacks) continue;
+        printf("    %s pool inUse=%d highWater=%d size=%d fallbacks=%lu statusMerged=%lu\n",
+               pPvt->pmr->name, pPvt->poolInUse, pPvt->poolHighWater,
+               MOTOR_ASYN_POOL_SIZE, pPvt->poolFallbacks, pPvt->statusMerged);
+        if (level >= 2 && pPvt->pPort && pPvt->pPort->trace)
+            report_trace(pPvt->pmr->name, pPvt->traceLatency);
+    }
+    return 0;
+}
+
+/* Pre-build the requests used by build_trans() */
+static void init_request_pool(motorAsynPvt *pPvt)
+{
+    int i;
+
+    pPvt->poolLock = epicsMutexMustCreate();
+    for (i = 0; i < MOTOR_ASYN_POOL_SIZE; i++) {
+        motorAsynRequest *preq = &pPvt->pool[i];
+        preq->pasynUser = pasynManager->duplicateAsynUser(pPvt->pasynUser, asynCallback, 0);
+        preq->pasynUser->userData = &preq->msg;
+        preq->msg.pasynUser = preq->pasynUser;
+        preq->msg.poolIndex = i;
+        preq->inUse = 0;
+    }
+}
+
+/* Get a request from the pool, fall back to the allocator if the pool is empty */
+static motorAsynMessage *alloc_request(motorAsynPvt *pPvt, asynUser **ppasynUser)
+{
+    motorAsynMessage *pmsg;
+    int i;
+
+    if (pPvt->poolLock) {
+        epicsMutexMustLock(pPvt->poolLock);
+        for (i = 0; i < MOTOR_ASYN_POOL_SIZE; i++) {
+            motorAsynRequest *preq = &pPvt->pool[i];
+            if (preq->inUse) continue;
+            preq->inUse = 1;
+            pPvt->poolInUse++;
+            if (pPvt->poolInUse > pPvt->poolHighWater)
+                pPvt->poolHighWater = pPvt->poolInUse;
+            epicsMutexUnlock(pPvt->poolLock);
+            *ppasynUser = preq->pasynUser;
+            preq->msg.stopAnnounced = 0;
+            preq->msg.traced = 0;
+            preq->msg.stopGeneration = epicsAtomicGetIntT(&pPvt->stopGeneration);
+            return &preq->msg;
+        }
+        pPvt->poolFallbacks++;
+        epicsMutexUnlock(pPvt->poolLock);
+    }
+    /* Make a copy of asynUser.  This is needed because we can have multiple
+     * requests queued.  It will be freed in the callback */
+    *ppasynUser = pasynManager->duplicateAsynUser(pPvt->pasynUser, asynCallback, 0);
+    pmsg = pasynManager->memMalloc(sizeof *pmsg);
+    pmsg->poolIndex = -1;
+    pmsg->stopAnnounced = 0;
+    pmsg->traced = 0;
+    pmsg->stopGeneration = epicsAtomicGetIntT(&pPvt->stopGeneration);
+    pmsg->pasynUser = *ppasynUser;
+    (*ppasynUser)->userData = pmsg;
+    return pmsg;
+}
+
+/* Give a request back to the pool, or free it */
+static void free_request(motorAsynPvt *pPvt, asynUser *pasynUser, motorAsynMessage *pmsg)
+{
+    if (pmsg->poolIndex >= 0) {
+        epicsMutexMustLock(pPvt->poolLock);
+        pPvt->pool[pmsg->poolIndex].inUse = 0;
+        pPvt->poolInUse--;
+        epicsMutexUnlock(pPvt->poolLock);
+        return;
+    }
+    pasynManager->memFree(pmsg, sizeof(*pmsg));
+    if (pasynManager->freeAsynUser(pasynUser) != asynSuccess) {
+        asynPrint(pPvt->pasynUser, ASYN_TRACE_ERROR,
+                  "devMotorAsyn::free_request: %s error in freeAsynUser\n",
+                  pPvt->pmr->name);
+    }
+}
+
+/* Find the state of a port, create it if needed.
+ * Only called from iocsh and init_record, so the list needs no lock */
+static motorAsynPort *get_port(const char *portName)
+{
+    motorAsynPort *pPort;
+    asynInterface *pasynInterface;
+
+    for (pPort = (motorAsynPort *)ellFirst(&motorAsynPortList); pPort;
+         pPort = (motorAsynPort *)ellNext(&pPort->node)) {
+        if (!strcmp(pPort->portName, portName)) return pPort;
+    }
+
+    pPort = callocMustSucceed(1, sizeof(motorAsynPort), "devMotorAsyn get_port()");
+    pPort->pasynUser = pasynManager->createAsynUser(groupCallback, 0);
+    pPort->pasynUser->userPvt = pPort;
+    if (pasynManager->connectDevice(pPort->pasynUser, portName, 0) != asynSuccess)
+        goto bad;
+    pPort->pasynUserRestore = pasynManager->duplicateAsynUser(pPort->pasynUser,
+                                                              restoreCallback, 0);
+    pasynInterface = pasynManager->findInterface(pPort->pasynUser, asynInt32Type, 1);
+    if (!pasynInterface)
+        goto bad;
+    pPort->pasynInt32 = (asynInt32 *)pasynInterface->pinterface;
+    pPort->asynInt32Pvt = pasynInterface->drvPvt;
+    pasynInterface = pasynManager->findInterface(pPort->pasynUser, asynDrvUserType, 1);
+    if (!pasynInterface)
+        goto bad;
+    pPort->deferMovesReason = -1;
+    if (((asynDrvUser *)pasynInterface->pinterface)->create(pasynInterface->drvPvt,
+            pPort->pasynUser, motorDeferMovesString, NULL, NULL) == asynSuccess)
+        pPort->deferMovesReason = pPort->pasynUser->reason;
+    pPort->portName = epicsStrDup(portName);
+    pPort->lock = epicsMutexMustCreate();
+    callbackSetCallback(groupTimerCallback, &pPort->timer);
+    callbackSetPriority(priorityHigh, &pPort->timer);
+    callbackSetUser(pPort, &pPort->timer);
+    ellAdd(&motorAsynPortList, &pPort->node);
+    return pPort;
+
+bad:
+    if (pPort->pasynUserRestore)
+        pasynManager->freeAsynUser(pPort->pasynUserRestore);
+    pasynManager->freeAsynUser(pPort->pasynUser);
+    free(pPort);
+    return NULL;
+}
+
+/* Find the histogram bin of a latency, the last bin takes the rest */
+static int latency_bin(const double *limits, int numLimits,
+                       const epicsTimeStamp *start, const epicsTimeStamp *end)
+{
+    double latency = epicsTimeDiffInSeconds(end, start);
+    int i;
+
+    for (i = 0; i < numLimits; i++)
+        if (latency < limits[i]) break;
+    return i;
+}
+
+/* Count a stop in the latency histogram of the port */
+static void add_stop_latency(motorAsynPort *pPort, const epicsTimeStamp *start)
+{
+    epicsTimeStamp now;
+    int i;
+
+    epicsTimeGetCurrent(&now);
+    i = latency_bin(stopLatencyLimits, NELEMENTS(stopLatencyLimits), start, &now);
+    epicsMutexMustLock(pPort->lock);
+    pPort->stopLatency[i]++;
+    epicsMutexUnlock(pPort->lock);
+}
+
+/* Count a stage of a traced move in the histograms of the record and the port */
+static void add_trace_latency(motorAsynPvt *pPvt, traceStage stage,
+                              const epicsTimeStamp *start, const epicsTimeStamp *end)
+{
+    int i = latency_bin(traceLatencyLimits, NELEMENTS(traceLatencyLimits), start, end);
+
+    epicsMutexMustLock(pPvt->pPort->lock);
+    pPvt->traceLatency[stage][i]++;
+    pPvt->pPort->traceLatency[stage][i]++;
+    epicsMutexUnlock(pPvt->pPort->lock);
+}
+
+/* Start the latency trace of a move */
+static void trace_move(motorAsynPvt *pPvt, motorAsynMessage *pmsg)
+{
+    if (!pPvt->pPort || !pPvt->pPort->trace)
+        return;
+    pmsg->traced = 1;
+    epicsTimeGetCurrent(&pmsg->traceTime);
+}
+
+/* iocsh: switch the latency trace of a port on or off.
+ * Switching it on clears the histograms. */
+int devMotorAsynLatencyTrace(const char *portName, int enable)
+{
+    motorAsynPort *pPort;
+    motorAsynPvt *pPvt;
+
+    if (!portName) {
+        printf("Usage: devMotorAsynLatencyTrace portName enable\n");
+        return -1;
+    }
+    pPort = get_port(portName);
+    if (!pPort) {
+        printf("devMotorAsynLatencyTrace: port %s not found\n", portName);
+        return -1;
+    }
+    epicsMutexMustLock(pPort->lock);
+    if (enable && !pPort->trace) {
+        memset(pPort->traceLatency, 0, sizeof(pPort->traceLatency));
+        for (pPvt = (motorAsynPvt *)ellFirst(&motorAsynPvtList); pPvt;
+             pPvt = (motorAsynPvt *)ellNext(&pPvt->node)) {
+            if (pPvt->pPort == pPort)
+                memset(pPvt->traceLatency, 0, sizeof(pPvt->traceLatency));
+        }
+    }
+    pPort->trace = enable ? 1 : 0;
+    epicsMutexUnlock(pPort->lock);
+    /* The stages in the driver */
+    if (pPort->pController)
+        asynAxisControllerLatencyTrace(pPort->pController, pPort->trace);
+    return 0;
+}
+
+/* iocsh: group the moves for a port that arrive within window seconds */
+int devMotorAsynGroupMoves(const char *portName, double window)
+{
+    motorAsynPort *pPort;
+
+    if (!portName) {
+        printf("Usage: devMotorAsynGroupMoves portName window\n");
+        return -1;
+    }
+    pPort = get_port(portName);
+    if (!pPort || pPort->deferMovesReason < 0) {
+        printf("devMotorAsynGroupMoves: port %s not found or has no %s\n",
+               portName, motorDeferMovesString);
+        return -1;
+    }
+    epicsMutexMustLock(pPort->lock);
+    pPort->window = window;
+    epicsMutexUnlock(pPort->lock);
+    return 0;
+}
+
+/* Add a compound move to the batch of its port, start the window if the
+ * batch was empty. Returns 0 if the port doesn't group moves */
+static int group_move(motorAsynPort *pPort, motorAsynMessage *pmsg)
+{
+    epicsMutexMustLock(pPort->lock);
+    if (!(pPort->window > 0.)) {
+        epicsMutexUnlock(pPort->lock);
+        return 0;
+    }
+    ellAdd(&pPort->pending, &pmsg->node);
+    if (!pPort->batchQueued) {
+        pPort->batchQueued = 1;
+        callbackRequestDelayed(&pPort->timer, pPort->window);
+    }
+    epicsMutexUnlock(pPort->lock);
+    return 1;
+}
+
+/* A move of the batch is not sent, give it back like asynCallback() does.
+ * Called with the record locked, if iocInit has completed */
+static void drop_group_move(motorAsynPvt *pPvt, motorAsynMessage *pmsg)
+{
+    pPvt->moveRequestPending--;
+    free_request(pPvt, pmsg->pasynUser, pmsg);
+}
+
+/* The window is over, queue the batch */
+static void groupTimerCallback(CALLBACK *pcallback)
+{
+    motorAsynPort *pPort;
+    motorAsynMessage *pmsg;
+    ELLLIST batch = ELLLIST_INIT;
+
+    callbackGetUser(pPort, pcallback);
+    if (pasynManager->queueRequest(pPort->pasynUser, 0, 0) == asynSuccess)
+        return;
+
+    asynPrint(pPort->pasynUser, ASYN_TRACE_ERROR,
+              "devMotorAsyn::groupTimerCallback: port %s error calling queueRequest, %s\n",
+              pPort->portName, pPort->pasynUser->errorMessage);
+    epicsMutexMustLock(pPort->lock);
+    ellConcat(&batch, &pPort->pending);
+    pPort->batchQueued = 0;
+    epicsMutexUnlock(pPort->lock);
+
+    /* build_trans() locks the port with the record locked, so the record
+     * is locked without holding the port lock */
+    while ((pmsg = (motorAsynMessage *)ellGet(&batch))) {
+        motorAsynPvt *pPvt = (motorAsynPvt *)pmsg->pasynUser->userPvt;
+        axisRecord *pmr = pPvt->pmr;
+
+        dbScanLock((dbCommon *)pmr);
+        drop_group_move(pPvt, pmsg);
+        if (!pPvt->moveRequestPending) {
+            take_latest_status(pPvt);
+            pPvt->needUpdate = 1;
+            dbProcess((dbCommon *)pmr);
+        }
+        dbScanUnlock((dbCommon *)pmr);
+    }
+}
+
+/* A stop cancels the moves of the record that wait for the next batch.
+ * Called from build_trans() with the record locked */
+static void cancel_group_moves(motorAsynPvt *pPvt)
+{
+    motorAsynPort *pPort = pPvt->pPort;
+    motorAsynMessage *pmsg, *pnext;
+    ELLLIST cancelled = ELLLIST_INIT;
+
+    epicsMutexMustLock(pPort->lock);
+    for (pmsg = (motorAsynMessage *)ellFirst(&pPort->pending); pmsg; pmsg = pnext) {
+        pnext = (motorAsynMessage *)ellNext(&pmsg->node);
+        if (pmsg->pasynUser->userPvt != pPvt) continue;
+        ellDelete(&pPort->pending, &pmsg->node);
+        ellAdd(&cancelled, &pmsg->node);
+    }
+    epicsMutexUnlock(pPort->lock);
+
+    while ((pmsg = (motorAsynMessage *)ellGet(&cancelled))) {
+        asynPrint(pPvt->pasynUser, ASYN_TRACE_FLOW,
+                  "devMotorAsyn::cancel_group_moves: %s move cancelled by stop\n",
+                  pPvt->pmr->name);
+        drop_group_move(pPvt, pmsg);
+    }
+}
+
+/* Send all moves of the batch while the controller defers them */
+static void groupCallback(asynUser *pasynUser)
+{
+    motorAsynPort *pPort = (motorAsynPort *)pasynUser->userPvt;
+    motorAsynMessage *pmsg;
+    ELLLIST batch = ELLLIST_INIT;
+    int count;
+
+    epicsMutexMustLock(pPort->lock);
+    ellConcat(&batch, &pPort->pending);
+    pPort->batchQueued = 0;
+    epicsMutexUnlock(pPort->lock);
+
+    /* A stop may have cancelled all moves of the batch */
+    count = ellCount(&batch);
+    if (!count)
+        return;
+    pPort->batches++;
+    pPort->batchedMoves += count;
+    if (count > pPort->maxBatch)
+        pPort->maxBatch = count;
+    asynPrint(pasynUser, ASYN_TRACE_FLOW,
+              "devMotorAsyn::groupCallback: port %s %d moves\n",
+              pPort->portName, count);
+
+    pasynUser->reason = pPort->deferMovesReason;
+    if (count > 1)
+        pPort->pasynInt32->write(pPort->asynInt32Pvt, pasynUser, 1);
+    /* asynCallback() sends the move and gives the request back */
+    while ((pmsg = (motorAsynMessage *)ellGet(&batch)))
+        asynCallback(pmsg->pasynUser);
+    if (count > 1)
+        pPort->pasynInt32->write(pPort->asynInt32Pvt, pasynUser, 0);
+}
+
 static int load_pos_needed(struct axisRecord *pmr, asynUser *pasynUser)
 {
     /* This routine is copied out of the old motordevCom and initialises the controller
@@ -196,6 +783,99 @@ static int load_pos_needed(struct axisRecord *pmr, asynUser *pasynUser)
     return 0;
 }
 
+/* Leave the LOAD_POS of init_record() to restoreCallback(), which init(1)
+ * queues once per port.  Until then the record has the position that is
+ * restored, and statuses from the driver don't overwrite it */
+static void defer_load_pos(struct axisRecord *pmr, double setPos)
+{
+    motorAsynPvt *pPvt = (motorAsynPvt *)pmr->dpvt;
+    motorAsynPort *pPort = pPvt->pPort;
+    asynUser *pasynUser;
+    motorAsynMessage *pmsg;
+
+    pmsg = alloc_request(pPvt, &pasynUser);
+    pmsg->command = motorPosition;
+    pmsg->interface = float64Type;
+    pmsg->ivalue = 0;
+    pmsg->dvalue = setPos;
+    pPvt->moveRequestPending++;
+
+    epicsMutexMustLock(pPvt->statusLock);
+    pPvt->restorePending = 1;
+    pPvt->status.position = setPos;
+    epicsMutexUnlock(pPvt->statusLock);
+
+    epicsMutexMustLock(pPort->lock);
+    ellAdd(&pPort->restores, &pmsg->node);
+    epicsMutexUnlock(pPort->lock);
+
+    asynPrint(pasynUser, ASYN_TRACE_FLOW,
+              "devMotorAsyn::defer_load_pos, %s position %f restored after init_record\n",
+              pmr->name, setPos);
+}
+
+/* Restore the positions of the records of a port, in one request of the port */
+static void restoreCallback(asynUser *pasynUser)
+{
+    motorAsynPort *pPort = (motorAsynPort *)pasynUser->userPvt;
+    motorAsynMessage *pmsg;
+    ELLLIST restores = ELLLIST_INIT;
+    epicsTimeStamp start, end;
+
+    epicsTimeGetCurrent(&start);
+    epicsMutexMustLock(pPort->lock);
+    ellConcat(&restores, &pPort->restores);
+    epicsMutexUnlock(pPort->lock);
+    asynPrint(pasynUser, ASYN_TRACE_FLOW,
+              "devMotorAsyn::restoreCallback: port %s %d positions\n",
+              pPort->portName, ellCount(&restores));
+
+    pPort->restoredPositions += ellCount(&restores);
+    /* asynCallback() writes the position, gives the request back and
+       processes the record with the status that follows it */
+    while ((pmsg = (motorAsynMessage *)ellGet(&restores))) {
+        motorAsynPvt *pPvt = (motorAsynPvt *)pmsg->pasynUser->userPvt;
+
+        epicsMutexMustLock(pPvt->statusLock);
+        pPvt->restorePending = 0;
+        epicsMutexUnlock(pPvt->statusLock);
+        asynCallback(pmsg->pasynUser);
+    }
+    epicsTimeGetCurrent(&end);
+    pPort->restoreTime += epicsTimeDiffInSeconds(&end, &start);
+}
+
+/* The restore request could not be queued, give the requests back */
+static void drop_restores(motorAsynPort *pPort)
+{
+    motorAsynMessage *pmsg;
+    ELLLIST restores = ELLLIST_INIT;
+
+    epicsMutexMustLock(pPort->lock);
+    ellConcat(&restores, &pPort->restores);
+    epicsMutexUnlock(pPort->lock);
+
+    while ((pmsg = (motorAsynMessage *)ellGet(&restores))) {
+        motorAsynPvt *pPvt = (motorAsynPvt *)pmsg->pasynUser->userPvt;
+        axisRecord *pmr = pPvt->pmr;
+
+        asynPrint(pPvt->pasynUser, ASYN_TRACE_ERROR,
+                  "devMotorAsyn::drop_restores: %s position not restored\n",
+                  pmr->name);
+        dbScanLock((dbCommon *)pmr);
+        epicsMutexMustLock(pPvt->statusLock);
+        pPvt->restorePending = 0;
+        epicsMutexUnlock(pPvt->statusLock);
+        drop_group_move(pPvt, pmsg);
+        if (!pPvt->moveRequestPending) {
+            take_latest_status(pPvt);
+            pPvt->needUpdate = 1;
+            dbProcess((dbCommon *)pmr);
+        }
+        dbScanUnlock((dbCommon *)pmr);
+    }
+}
+
 static void init_controller_load_pos_if_needed(struct axisRecord *pmr, asynUser *pasynUser )
 {
     /* This routine is copied out of the old motordevCom and initialises the controller
@@ -207,7 +887,13 @@ static void init_controller_load_pos_if_needed(struct axisRecord *pmr, asynUser
     if (load_pos_needed(pmr, pasynUser))
     {
         double setPos = pmr->dval / pmr->mres;
-        epicsEventId initEvent = epicsEventCreate( epicsEventEmpty );
+        epicsEventId initEvent;
+
+        if (pPvt->pPort) {
+            defer_load_pos(pmr, setPos);
+            return;
+        }
+        initEvent = epicsEventCreate( epicsEventEmpty );
 
         pPvt->initEvent = initEvent;
 
@@ -300,9 +986,10 @@ static asynStatus config_controller(struct axisRecord *pmr, motorAsynPvt *pPvt)
     pasynUser->reason = pPvt->driverReasons[motorRecResolution];
     status = pPvt->pasynFloat64->write(pPvt->asynFloat64Pvt, pasynUser, pmr->mres);
 
-    /* force a poll() in the driver */
+    /* Make sure the driver has polled the axis.  All axes of the controller
+       are polled together for the first record, or already by the poller */
     pasynUser->reason = pPvt->driverReasons[motorUpdateStatus];
-    pPvt->pasynInt32->write(pPvt->asynFloat64Pvt, pasynUser, 1);
+    pPvt->pasynInt32->write(pPvt->asynFloat64Pvt, pasynUser, MOTOR_UPDATE_STATUS_INIT);
     
     pasynManager->freeAsynUser(pasynUser);
     return status;
@@ -310,7 +997,7 @@ static asynStatus config_controller(struct axisRecord *pmr, motorAsynPvt *pPvt)
 
 
 
-static long init_record(struct axisRecord * pmr )
+static long init_record_port(struct axisRecord * pmr )
 {
     asynUser *pasynUser;
     char *port, *userParam;
@@ -340,6 +1027,7 @@ static long init_record(struct axisRecord * pmr )
     }
 
     /* Connect to device */
+    pPvt->axis = signal;
     status = pasynManager->connectDevice(pasynUser, port, signal);
     if (status != asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
@@ -379,28 +1067,55 @@ static long init_record(struct axisRecord * pmr )
     pPvt->pasynDrvUser = (asynDrvUser *)pasynInterface->pinterface;
     pPvt->asynDrvUserPvt = pasynInterface->drvPvt;
 
-    /* Now that we have the drvUser interface get pasynUser->reason for each command */
-    if (findDrvInfo(pmr, pasynUser, motorMoveRelString,                motorMoveRel)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorMoveAbsString,                motorMoveAbs)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorMoveVelString,                motorMoveVel)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorHomeString,                   motorHome)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorStopString,                   motorStop)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorVelocityString,               motorVelocity)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorVelBaseString,                motorVelBase)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorAccelString,                  motorAccel)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorPositionString,               motorPosition)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorRecResolutionString,          motorRecResolution)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorRecDirectionString,           motorRecDirection)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorRecOffsetString,              motorRecOffset)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorEncoderRatioString,           motorEncRatio)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorPGainString,                  motorPGain)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorIGainString,                  motorIGain)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorDGainString,                  motorDGain)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorHighLimitString,              motorHighLimit)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorLowLimitString,               motorLowLimit)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorClosedLoopString,             motorSetClosedLoop)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorStatusString,                 motorStatus)) goto bad;
-    if (findDrvInfo(pmr, pasynUser, motorUpdateStatusString,           motorUpdateStatus)) goto bad;
+    /* Now that we have the drvUser interface get pasynUser->reason for each command.
+       They are the same for all axes of a port, so only the first record looks them up */
+    pPvt->pPort = get_port(port);
+    if (pPvt->pPort && pPvt->pPort->reasonsValid) {
+        memcpy(pPvt->driverReasons, pPvt->pPort->driverReasons, sizeof(pPvt->driverReasons));
+        pPvt->compoundSupported = pPvt->pPort->compoundSupported;
+        pPvt->retargetSupported = pPvt->pPort->retargetSupported;
+    } else {
+        if (findDrvInfo(pmr, pasynUser, motorMoveRelString,                motorMoveRel)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorMoveAbsString,                motorMoveAbs)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorMoveVelString,                motorMoveVel)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorHomeString,                   motorHome)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorStopString,                   motorStop)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorVelocityString,               motorVelocity)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorVelBaseString,                motorVelBase)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorAccelString,                  motorAccel)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorPositionString,               motorPosition)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorRecResolutionString,          motorRecResolution)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorRecDirectionString,           motorRecDirection)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorRecOffsetString,              motorRecOffset)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorEncoderRatioString,           motorEncRatio)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorPGainString,                  motorPGain)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorIGainString,                  motorIGain)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorDGainString,                  motorDGain)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorHighLimitString,              motorHighLimit)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorLowLimitString,               motorLowLimit)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorClosedLoopString,             motorSetClosedLoop)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorStatusString,                 motorStatus)) goto bad;
+        if (findDrvInfo(pmr, pasynUser, motorUpdateStatusString,           motorUpdateStatus)) goto bad;
+        /* Optional, drivers not derived from asynAxisController don't have it */
+        pPvt->compoundSupported =
+            pPvt->pasynDrvUser->create(pPvt->asynDrvUserPvt, pasynUser,
+                                       motorMoveCompoundString, NULL, NULL) == asynSuccess;
+        if (pPvt->compoundSupported)
+            pPvt->driverReasons[motorMoveCompound] = pasynUser->reason;
+        pPvt->retargetSupported =
+            pPvt->pasynDrvUser->create(pPvt->asynDrvUserPvt, pasynUser,
+                                       motorRetargetString, NULL, NULL) == asynSuccess;
+        if (pPvt->retargetSupported)
+            pPvt->driverReasons[motorRetarget] = pasynUser->reason;
+        if (pPvt->pPort && pPvt->compoundSupported)
+            pPvt->pPort->pController = asynAxisControllerFind(port);
+        if (pPvt->pPort) {
+            memcpy(pPvt->pPort->driverReasons, pPvt->driverReasons, sizeof(pPvt->driverReasons));
+            pPvt->pPort->compoundSupported = pPvt->compoundSupported;
+            pPvt->pPort->retargetSupported = pPvt->retargetSupported;
+            pPvt->pPort->reasonsValid = 1;
+        }
+    }
     
     /* Get the asynFloat64Array interface */
     pasynInterface = pasynManager->findInterface(pasynUser,
@@ -426,6 +1141,13 @@ static long init_record(struct axisRecord * pmr )
     pPvt->pasynGenericPointer = (asynGenericPointer *)pasynInterface->pinterface;
     pPvt->asynGenericPointerPvt = pasynInterface->drvPvt;
 
+    init_request_pool(pPvt);
+    ellAdd(&motorAsynPvtList, &pPvt->node);
+    pPvt->statusLock = epicsMutexMustCreate();
+    callbackSetCallback(statusCallbackProcess, &pPvt->statusCb);
+    callbackSetPriority(pmr->prio, &pPvt->statusCb);
+    callbackSetUser(pPvt, &pPvt->statusCb);
+
     /* Send MRES, offset, direction and encoder ratio to the driver as soon as
        possible */
        
@@ -508,6 +1230,24 @@ bad:
     return(0);
 }
 
+/* Time the initialisation of the records, per port, see report() */
+static long init_record(struct axisRecord * pmr )
+{
+    motorAsynPvt *pPvt;
+    epicsTimeStamp start, end;
+    long rc;
+
+    epicsTimeGetCurrent(&start);
+    rc = init_record_port(pmr);
+    epicsTimeGetCurrent(&end);
+    pPvt = (motorAsynPvt *)pmr->dpvt;
+    if (pPvt && pPvt->pPort) {
+        pPvt->pPort->initRecords++;
+        pPvt->pPort->initTime += epicsTimeDiffInSeconds(&end, &start);
+    }
+    return(rc);
+}
+
 
 
 CALLBACK_VALUE update_values(struct axisRecord * pmr)
@@ -571,9 +1311,42 @@ CALLBACK_VALUE update_values(struct axisRecord * pmr)
 
 static long start_trans(struct axisRecord * pmr )
 {
+    motorAsynPvt *pPvt = (motorAsynPvt *)pmr->dpvt;
+
+    if (pPvt->compoundSupported) {
+        pPvt->transActive = 1;
+        pPvt->transMove = -1;
+        memset(&pPvt->trans, 0, sizeof(pPvt->trans));
+    }
     return(OK);
 }
 
+/* Send the motion settings collected in the transaction one by one.
+ * build_trans() calls this before a command that isn't collected, so that
+ * the driver gets the settings and that command in the order of the record. */
+static RTN_STATUS flush_trans_settings(struct axisRecord * pmr)
+{
+    motorAsynPvt *pPvt = (motorAsynPvt *)pmr->dpvt;
+    int mask = pPvt->trans.mask &
+        (MOTOR_COMPOUND_VELOCITY | MOTOR_COMPOUND_VEL_BASE | MOTOR_COMPOUND_ACCEL);
+    int transActive = pPvt->transActive;
+    RTN_STATUS rtnind = OK;
+
+    if (!mask)
+        return(OK);
+    pPvt->trans.mask &= ~mask;
+    /* Don't collect them again */
+    pPvt->transActive = 0;
+    if (mask & MOTOR_COMPOUND_VELOCITY)
+        if (build_trans(SET_VELOCITY, &pPvt->trans.velocity, pmr) != OK) rtnind = ERROR;
+    if (mask & MOTOR_COMPOUND_VEL_BASE)
+        if (build_trans(SET_VEL_BASE, &pPvt->trans.velBase, pmr) != OK) rtnind = ERROR;
+    if (mask & MOTOR_COMPOUND_ACCEL)
+        if (build_trans(SET_ACCEL, &pPvt->trans.accel, pmr) != OK) rtnind = ERROR;
+    pPvt->transActive = transActive;
+    return(rtnind);
+}
+
 static RTN_STATUS build_trans( motor_cmnd command, 
                    double * param,
                    struct axisRecord * pmr )
@@ -583,6 +1356,7 @@ static RTN_STATUS build_trans( motor_cmnd command,
     motorAsynPvt *pPvt = (motorAsynPvt *)pmr->dpvt;
     asynUser *pasynUser = pPvt->pasynUser;
     motorAsynMessage *pmsg;
+    asynQueuePriority priority = asynQueuePriorityLow;
     int need_call=0;
 
     asynPrint(pasynUser, ASYN_TRACE_FLOW,
@@ -616,19 +1390,78 @@ static RTN_STATUS build_trans( motor_cmnd command,
         return (OK);
     }
 
+    /* Only a compound move carries the backlash approach */
+    if (command == SET_BACKLASH) {
+        if (!pPvt->transActive)
+            return(ERROR);
+        pPvt->trans.backlashValue = param[0];
+        pPvt->trans.backlashVelocity = param[1];
+        pPvt->trans.backlashAccel = param[2];
+        pPvt->trans.mask |= MOTOR_COMPOUND_BACKLASH;
+        return(OK);
+    }
+
+    /* The same for the retries of the move */
+    if (command == SET_RETRY) {
+        if (!pPvt->transActive)
+            return(ERROR);
+        pPvt->trans.retryDeadband = param[0];
+        pPvt->trans.retryCount = (int)param[1];
+        pPvt->trans.retryFraction = param[2];
+        pPvt->trans.retryUseEncoder = (param[3] != 0.0);
+        pPvt->trans.mask |= MOTOR_COMPOUND_RETRY;
+        return(OK);
+    }
+
+    /* Only drivers that say so can change the target of a move */
+    if ((command == RETARGET) &&
+        !(pPvt->retargetSupported && (pmr->mflg & MF_RETARGET)))
+        return(ERROR);
+
+    /* Inside a transaction the motion settings and the move are collected
+     * here and sent by end_trans() */
+    if (pPvt->transActive) {
+        switch (command) {
+            case SET_VEL_BASE:
+                pPvt->trans.velBase = *param;
+                pPvt->trans.mask |= MOTOR_COMPOUND_VEL_BASE;
+                return(OK);
+            case SET_VELOCITY:
+                pPvt->trans.velocity = *param;
+                pPvt->trans.mask |= MOTOR_COMPOUND_VELOCITY;
+                return(OK);
+            case SET_ACCEL:
+                pPvt->trans.accel = *param;
+                pPvt->trans.mask |= MOTOR_COMPOUND_ACCEL;
+                return(OK);
+            case GO:
+                pPvt->transMove = pPvt->move_cmd;
+                pPvt->trans.value = pPvt->param;
+                pPvt->move_cmd = -1;
+                return(OK);
+            case JOG:
+            case JOG_VELOCITY:
+                pPvt->transMove = motorMoveVel;
+                pPvt->trans.value = *param;
+                return(OK);
+            default:
+                /* The settings collected so far go out before this command */
+                if (flush_trans_settings(pmr) != OK)
+                    rtnind = ERROR;
+                break;
+        }
+    }
+
     /* If we are already in COMM_ALARM then this server is not reachable,
      * return */
     if ((pmr->nsta == COMM_ALARM) || (pmr->stat == COMM_ALARM))
         return(ERROR);
 
-   /* Make a copy of asynUser.  This is needed because we can have multiple
-    * requests queued.  It will be freed in the callback */
-    pasynUser = pasynManager->duplicateAsynUser(pasynUser, asynCallback, 0);
-    pmsg = pasynManager->memMalloc(sizeof *pmsg);
+   /* Take a request from the pool, it is given back in the callback */
+    pmsg = alloc_request(pPvt, &pasynUser);
     pmsg->ivalue=0;
     pmsg->dvalue=0.;
     pmsg->interface = float64Type;
-    pasynUser->userData = pmsg;
  
     switch (command) {
         case LOAD_POS:
@@ -653,6 +1486,7 @@ static RTN_STATUS build_trans( motor_cmnd command,
             pmsg->dvalue = pPvt->param;
             pPvt->move_cmd = -1;
             pPvt->moveRequestPending++;
+            trace_move(pPvt, pmsg);
             /* Do we need to set needUpdate and schedule a process here? */
             /* or can we always guarantee to get at least one callback? */
             /* Do we really need the callback? I assume so */
@@ -664,12 +1498,29 @@ static RTN_STATUS build_trans( motor_cmnd command,
         case STOP_AXIS:
             pmsg->command = motorStop;
             pmsg->interface = int32Type;
+            /* Stops overtake the other requests of the port */
+            priority = asynQueuePriorityHigh;
+            epicsTimeGetCurrent(&pmsg->stopTime);
+            /* The moves held for the next batch must not follow the stop,
+               asynCallback() drops the ones in the queue */
+            if (pPvt->pPort)
+                cancel_group_moves(pPvt);
+            epicsAtomicIncrIntT(&pPvt->stopGeneration);
+            if (pPvt->pPort && pPvt->pPort->pController) {
+                pmsg->stopAnnounced = 1;
+                if (asynAxisControllerStopBegin(pPvt->pPort->pController, pPvt->axis)) {
+                    /* The driver has sent the stop on a channel of its own */
+                    pmsg->stopAnnounced = 2;
+                    add_stop_latency(pPvt->pPort, &pmsg->stopTime);
+                }
+            }
             break;
         case JOG:
         case JOG_VELOCITY:
             pmsg->command = motorMoveVel;
             pmsg->dvalue = *param;
             pPvt->moveRequestPending++;
+            trace_move(pPvt, pmsg);
             break;
         case SET_PGAIN:
             pmsg->command = motorPGain;
@@ -697,6 +1548,7 @@ static RTN_STATUS build_trans( motor_cmnd command,
             asynPrint(pasynUser, ASYN_TRACE_ERROR,
                   "devMotorAsyn::build_trans: %s: PRIMITIVE no longer supported\n",
                   pmr->name);
+            free_request(pPvt, pasynUser, pmsg);
             return(ERROR);
         case SET_HIGH_LIMIT:
             pmsg->command = motorHighLimit;
@@ -710,10 +1562,16 @@ static RTN_STATUS build_trans( motor_cmnd command,
             pmsg->command = motorUpdateStatus;
             pmsg->interface = int32Type;
             break;
+        case RETARGET:
+            pmsg->command = motorRetarget;
+            pmsg->dvalue = *param;
+            pPvt->moveRequestPending++;
+            break;
         default:
             asynPrint(pasynUser, ASYN_TRACE_ERROR,
                   "devMotorAsyn::build_trans: %s: motor command %d not recognised\n",
                   pmr->name, command);
+            free_request(pPvt, pasynUser, pmsg);
             return(ERROR);
     }
 
@@ -724,11 +1582,14 @@ static RTN_STATUS build_trans( motor_cmnd command,
 
     /* Queue asyn request, so we get a callback when driver is ready */
     pasynUser->reason = pPvt->driverReasons[pmsg->command];
-    status = pasynManager->queueRequest(pasynUser, 0, 0);
+    status = pasynManager->queueRequest(pasynUser, priority, 0);
     if (status != asynSuccess) {
         asynPrint(pasynUser, ASYN_TRACE_ERROR,
               "devMotorAsyn::build_trans: %s error calling queueRequest, %s\n",
               pmr->name, pasynUser->errorMessage);
+        if (pmsg->stopAnnounced)
+            asynAxisControllerStopEnd(pPvt->pPort->pController);
+        free_request(pPvt, pasynUser, pmsg);
         rtnind = ERROR;
     }
     return(rtnind);
@@ -736,7 +1597,74 @@ static RTN_STATUS build_trans( motor_cmnd command,
 
 static RTN_STATUS end_trans(struct axisRecord * pmr )
 {
-  return(OK);
+    motorAsynPvt *pPvt = (motorAsynPvt *)pmr->dpvt;
+    asynUser *pasynUser;
+    motorAsynMessage *pmsg;
+    RTN_STATUS rtnind = OK;
+    asynStatus status;
+
+    if (!pPvt->transActive)
+        return(OK);
+    pPvt->transActive = 0;
+
+    if (pPvt->transMove < 0) {
+        /* Settings without a move, send them one by one */
+        return(flush_trans_settings(pmr));
+    }
+
+    if ((pmr->nsta == COMM_ALARM) || (pmr->stat == COMM_ALARM))
+        return(ERROR);
+
+    switch (pPvt->transMove) {
+        case motorMoveAbs: pPvt->trans.command = MOTOR_COMPOUND_MOVE_ABS; break;
+        case motorMoveRel: pPvt->trans.command = MOTOR_COMPOUND_MOVE_REL; break;
+        case motorMoveVel: pPvt->trans.command = MOTOR_COMPOUND_MOVE_VEL; break;
+        case motorHome:    pPvt->trans.command = MOTOR_COMPOUND_HOME;     break;
+        default:
+            asynPrint(pPvt->pasynUser, ASYN_TRACE_ERROR,
+                      "devMotorAsyn::end_trans: %s: move command %d not recognised\n",
+                      pmr->name, pPvt->transMove);
+            return(ERROR);
+    }
+
+    pmsg = alloc_request(pPvt, &pasynUser);
+    pmsg->command = motorMoveCompound;
+    pmsg->interface = genericPointerType;
+    pmsg->ivalue = 0;
+    pmsg->dvalue = pPvt->trans.value;
+    pmsg->move = pPvt->trans;
+    pPvt->moveRequestPending++;
+    trace_move(pPvt, pmsg);
+
+    asynPrint(pasynUser, ASYN_TRACE_FLOW,
+              "devMotorAsyn::end_trans: %s compound command=%d value=%f mask=0x%x\n",
+              pmr->name, pmsg->move.command, pmsg->move.value, pmsg->move.mask);
+
+    pasynUser->reason = pPvt->driverReasons[motorMoveCompound];
+    if (pPvt->pPort && group_move(pPvt->pPort, pmsg))
+        return(OK);
+    status = pasynManager->queueRequest(pasynUser, 0, 0);
+    if (status != asynSuccess) {
+        asynPrint(pasynUser, ASYN_TRACE_ERROR,
+              "devMotorAsyn::end_trans: %s error calling queueRequest, %s\n",
+              pmr->name, pasynUser->errorMessage);
+        pPvt->moveRequestPending--;
+        free_request(pPvt, pasynUser, pmsg);
+        rtnind = ERROR;
+    }
+    return(rtnind);
+}
+
+/* Copy the latest status from statusCallback() to status, if there is a
+ * new one. Called with the record locked, before it is processed */
+static void take_latest_status(motorAsynPvt *pPvt)
+{
+    epicsMutexMustLock(pPvt->statusLock);
+    if (pPvt->statusNew) {
+        memcpy(&pPvt->status, &pPvt->latestStatus, sizeof(struct MotorStatus));
+        pPvt->statusNew = 0;
+    }
+    epicsMutexUnlock(pPvt->statusLock);
 }
 
 /**
@@ -749,8 +1677,16 @@ static void asynCallback(asynUser *pasynUser)
     motorAsynPvt *pPvt = (motorAsynPvt *)pasynUser->userPvt;
     axisRecord *pmr = pPvt->pmr;
     motorAsynMessage *pmsg = pasynUser->userData;
+    motorCommand command = pmsg->command;
     int status;
     int commandIsMove = 0;
+    int dropped = 0;
+    epicsTimeStamp traceDequeued, traceWritten;
+
+    if (pmsg->traced) {
+        epicsTimeGetCurrent(&traceDequeued);
+        add_trace_latency(pPvt, traceQueue, &pmsg->traceTime, &traceDequeued);
+    }
 
     pasynUser->reason = pPvt->driverReasons[pmsg->command];
     asynPrint(pasynUser, ASYN_TRACE_FLOW,
@@ -759,6 +1695,28 @@ static void asynCallback(asynUser *pasynUser)
               pmr->name, pmsg, (int)sizeof(*pmsg), pmsg->command, 
               pmsg->interface, pmsg->ivalue, pmsg->dvalue, pasynUser->reason);
 
+    /* The stop has high priority and overtakes the moves in the queue.
+     * A move that was built before the latest stop must not start after it.
+     * build_trans() can't cancel them, cancelRequest() waits for a running
+     * asynCallback(), which may wait for the record lock that it holds. */
+    if (pmsg->stopGeneration != epicsAtomicGetIntT(&pPvt->stopGeneration)) {
+        switch (command) {
+            case motorMoveAbs:
+            case motorMoveRel:
+            case motorHome:
+            case motorMoveVel:
+            case motorMoveCompound:
+            case motorRetarget:
+                dropped = 1;
+                asynPrint(pasynUser, ASYN_TRACE_FLOW,
+                          "devMotorAsyn::asynCallback: %s move command=%d dropped, a stop came after it\n",
+                          pmr->name, command);
+                break;
+            default:
+                break;
+        }
+    }
+
     switch (pmsg->command) {
         case motorStatus:
             /* Read the current status of the device */
@@ -782,10 +1740,17 @@ static void asynCallback(asynUser *pasynUser)
         case motorHome:
         case motorPosition:
         case motorMoveVel:
+        case motorMoveCompound:
+        case motorRetarget:
         commandIsMove = 1;
+        if (dropped)
+            break;
         /* Intentional fall-through */
         default:
-            if (pmsg->interface == int32Type) {
+            if (pmsg->interface == genericPointerType) {
+                status = pPvt->pasynGenericPointer->write(pPvt->asynGenericPointerPvt,
+                             pasynUser, &pmsg->move);
+            } else if (pmsg->interface == int32Type) {
                 status = pPvt->pasynInt32->write(pPvt->asynInt32Pvt, pasynUser,
                              pmsg->ivalue);
             } else {
@@ -794,41 +1759,57 @@ static void asynCallback(asynUser *pasynUser)
             }
             if (status != asynSuccess) {
                 asynPrint(pasynUser, ASYN_TRACE_ERROR,
-                          "devMotorAsyn::asynCallback: %s pasyn{Float64,Int32}->write returned %s\n", 
+                          "devMotorAsyn::asynCallback: %s pasyn{Float64,Int32,GenericPointer}->write returned %s\n", 
                           pmr->name, pasynUser->errorMessage);
             }
             break;
     }
 
+    if (pmsg->stopAnnounced) {
+        asynAxisControllerStopEnd(pPvt->pPort->pController);
+        if (pmsg->stopAnnounced == 1)
+            add_stop_latency(pPvt->pPort, &pmsg->stopTime);
+    }
+
+    if (pmsg->traced) {
+        epicsTimeGetCurrent(&traceWritten);
+        add_trace_latency(pPvt, traceWrite, &traceDequeued, &traceWritten);
+    }
+
     if (dbScanLockOK) { /* effectively if iocInit has completed */
         dbScanLock((dbCommon *)pmr);
+        if (pmsg->traced) {
+            /* statusCallbackProcess() waits for DONE */
+            pPvt->traceActive = 1;
+            pPvt->traceStart = pmsg->traceTime;
+            pPvt->traceWritten = traceWritten;
+        }
         if (commandIsMove) {
             pPvt->moveRequestPending--;
             if (!pPvt->moveRequestPending) {
+                /* Statuses that came while the move was pending didn't process */
+                take_latest_status(pPvt);
                 pPvt->needUpdate = 1;
                 dbProcess((dbCommon*)pmr);
             }
         }
         dbScanUnlock((dbCommon *)pmr);
     }
-    else if (pmsg->command == motorPosition)
+    else if (command == motorPosition)
         pPvt->moveRequestPending = 0;
 
-    pasynManager->memFree(pmsg, sizeof(*pmsg));
-    status = pasynManager->freeAsynUser(pasynUser);
-    if (status != asynSuccess) {
-        asynPrint(pasynUser, ASYN_TRACE_ERROR,
-                  "devMotorAsyn::asynCallback: %s error in freeAsynUser, %s\n",
-                  pmr->name, pasynUser->errorMessage);
-    }
+    free_request(pPvt, pasynUser, pmsg);
 
-    if ( pPvt->initEvent && pmsg->command == motorPosition) {
+    if ( pPvt->initEvent && command == motorPosition) {
         epicsEventSignal( pPvt->initEvent );
     }
 }
 
 /**
  * True callback to notify that controller status has changed.
+ * Called by the poller with the port locked, so it only stores the status.
+ * The record is processed by statusCallbackProcess() from the callback queue,
+ * and statuses that arrive before that are merged into the latest one.
  */
 static void statusCallback(void *drvPvt, asynUser *pasynUser,
                void *pValue)
@@ -836,6 +1817,7 @@ static void statusCallback(void *drvPvt, asynUser *pasynUser,
     motorAsynPvt *pPvt = (motorAsynPvt *)drvPvt;
     axisRecord *pmr = pPvt->pmr;
     MotorStatus *value = (MotorStatus *)pValue;
+    int queue;
 
     asynPrint(pasynUser, ASYN_TRACEIO_DEVICE,
               "%s devMotorAsyn::statusCallback new value=[p:%f,e:%f,s:%x] %c%c\n",
@@ -843,18 +1825,102 @@ static void statusCallback(void *drvPvt, asynUser *pasynUser,
               pPvt->needUpdate ? 'N':' ', 
               pPvt->moveRequestPending ? 'P':' ');
 
-    if (dbScanLockOK) {
-        dbScanLock((dbCommon *)pmr);
-        memcpy(&pPvt->status, value, sizeof(struct MotorStatus));
-        if (!pPvt->moveRequestPending) {
-        pPvt->needUpdate = 1;
-        /* pmr->rset->process((dbCommon*)pmr); */
-            dbProcess((dbCommon*)pmr);
+    if (!dbScanLockOK) {
+        /* Before iocInit there are no callback threads and nobody processes.
+           The position of a deferred LOAD_POS is kept, see defer_load_pos() */
+        epicsMutexMustLock(pPvt->statusLock);
+        if (!pPvt->restorePending) {
+            memcpy(&pPvt->status, value, sizeof(struct MotorStatus));
+            pPvt->needUpdate = 1;
         }
-        dbScanUnlock((dbCommon*)pmr);
-    } else {
-        memcpy(&pPvt->status, value, sizeof(struct MotorStatus));
+        epicsMutexUnlock(pPvt->statusLock);
+        return;
+    }
+
+    epicsMutexMustLock(pPvt->statusLock);
+    memcpy(&pPvt->latestStatus, value, sizeof(struct MotorStatus));
+    pPvt->statusNew = 1;
+    queue = !pPvt->statusQueued;
+    if (queue) {
+        pPvt->statusQueued = 1;
+        if (pPvt->pPort && pPvt->pPort->trace)
+            epicsTimeGetCurrent(&pPvt->latestStatusTime);
+    } else
+        pPvt->statusMerged++;
+    epicsMutexUnlock(pPvt->statusLock);
+
+    if (queue && callbackRequest(&pPvt->statusCb)) {
+        /* Queue full, the next status will try again */
+        epicsMutexMustLock(pPvt->statusLock);
+        pPvt->statusQueued = 0;
+        epicsMutexUnlock(pPvt->statusLock);
+    }
+}
+
+/**
+ * Processes the record with the latest status from statusCallback().
+ */
+static void statusCallbackProcess(CALLBACK *pcallback)
+{
+    motorAsynPvt *pPvt;
+    axisRecord *pmr;
+    epicsTimeStamp statusTime, now;
+
+    callbackGetUser(pPvt, pcallback);
+    pmr = pPvt->pmr;
+
+    dbScanLock((dbCommon *)pmr);
+    epicsMutexMustLock(pPvt->statusLock);
+    if (pPvt->statusNew) {
+        /* Else asynCallback() has already taken it */
+        memcpy(&pPvt->status, &pPvt->latestStatus, sizeof(struct MotorStatus));
+        pPvt->statusNew = 0;
+    }
+    statusTime = pPvt->latestStatusTime;
+    pPvt->statusQueued = 0;
+    epicsMutexUnlock(pPvt->statusLock);
+    if (pPvt->pPort && pPvt->pPort->trace) {
+        epicsTimeGetCurrent(&now);
+        add_trace_latency(pPvt, traceDeliver, &statusTime, &now);
+        /* DONE from a status that was sent before the move was written belongs to an earlier move */
+        if (pPvt->traceActive && (pPvt->status.status & STATUS_BIT_DONE) &&
+            epicsTimeDiffInSeconds(&statusTime, &pPvt->traceWritten) >= 0.) {
+            add_trace_latency(pPvt, traceDone, &pPvt->traceWritten, &now);
+            add_trace_latency(pPvt, traceTotal, &pPvt->traceStart, &now);
+            pPvt->traceActive = 0;
+        }
+    }
+    if (!pPvt->moveRequestPending) {
         pPvt->needUpdate = 1;
+        dbProcess((dbCommon*)pmr);
     }
+    dbScanUnlock((dbCommon*)pmr);
+}
+
+static const iocshArg groupMovesArg0 = {"Port name", iocshArgString};
+static const iocshArg groupMovesArg1 = {"Window (sec)", iocshArgDouble};
+static const iocshArg * const groupMovesArgs[2] = {&groupMovesArg0, &groupMovesArg1};
+static const iocshFuncDef groupMovesDef = {"devMotorAsynGroupMoves", 2, groupMovesArgs};
+
+static void groupMovesCallFunc(const iocshArgBuf *args)
+{
+    devMotorAsynGroupMoves(args[0].sval, args[1].dval);
+}
+
+static const iocshArg latencyTraceArg0 = {"Port name", iocshArgString};
+static const iocshArg latencyTraceArg1 = {"Enable", iocshArgInt};
+static const iocshArg * const latencyTraceArgs[2] = {&latencyTraceArg0, &latencyTraceArg1};
+static const iocshFuncDef latencyTraceDef = {"devMotorAsynLatencyTrace", 2, latencyTraceArgs};
+
+static void latencyTraceCallFunc(const iocshArgBuf *args)
+{
+    devMotorAsynLatencyTrace(args[0].sval, args[1].ival);
+}
+
+static void devMotorAsynRegister(void)
+{
+    iocshRegister(&groupMovesDef, groupMovesCallFunc);
+    iocshRegister(&latencyTraceDef, latencyTraceCallFunc);
 }
 
+epicsExportRegistrar(devMotorAsynRegister);
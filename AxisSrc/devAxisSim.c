@@ -0,0 +1,634 @@
+/*
+ * devAxisSim.c
+ *
+ * Simulated device support for the axis record, for load tests of an IOC
+ * without a controller or a driver.
+ *
+ * Each record gets an in-memory motor that moves with a trapezoidal profile:
+ * it starts at VBAS, accelerates with the raw acceleration of the move up to
+ * the raw velocity, and decelerates down to VBAS at the target.  Jogs run until
+ * they are stopped, a stop decelerates to zero.  Homing moves to the raw
+ * position 0 and sets the HOME and HOMED bits.  SET_HIGH_LIMIT and
+ * SET_LOW_LIMIT arm limit switches at the given raw positions, the motor stops
+ * there with the limit bit set.  They are off while high <= low.  RETARGET
+ * plans the move again from where the motor is, without stopping.
+ *
+ * One timer thread serves all records.  Every period it evaluates the
+ * profiles of the moving motors and queues a process of their records.  The
+ * status arrives after latency plus a random delay between 0 and jitter
+ * seconds, like the reply of a controller.  A record that is still queued
+ * from an earlier tick is not queued again, it gets the latest status.
+ *
+ * OUT is "@" with DTYP "axisSim", all records share the settings of
+ *   devAxisSimConfig(period, latency, jitter)
+ * which can be called at any time.  The defaults are 0.1, 0 and 0 seconds.
+ * dbior("devAxisSim", 1) shows the counters of the timer thread.
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <dbAccess.h>
+#include <recGbl.h>
+#include <recSup.h>
+#include <devSup.h>
+#include <alarm.h>
+#include <errlog.h>
+#include <dbEvent.h>
+#include <callback.h>
+#include <iocsh.h>
+#include <epicsMutex.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <ellLib.h>
+#include <cantProceed.h>
+
+#include "axisRecord.h"
+#include "axis.h"
+#include "axis_priv.h"
+#include "epicsExport.h"
+#include "asynAxisController.h"
+
+static long report(int level);
+static long init(int after);
+static long init_record(struct axisRecord *);
+static CALLBACK_VALUE update_values(struct axisRecord *);
+static long start_trans(struct axisRecord *);
+static RTN_STATUS build_trans(motor_cmnd, double *, struct axisRecord *);
+static RTN_STATUS end_trans(struct axisRecord *);
+
+struct motor_dset devAxisSim = {
+    {
+         8,
+         (DEVSUPFUN) report,
+         (DEVSUPFUN) init,
+         (DEVSUPFUN) init_record,
+         NULL
+    },
+    update_values,
+    start_trans,
+    build_trans,
+    end_trans
+};
+
+epicsExportAddress(dset, devAxisSim);
+
+/* A profile is at most a deceleration to reverse, an acceleration,
+   a constant velocity and a deceleration */
+#define SIM_MAX_SEGMENTS 4
+
+typedef struct {
+    double duration;    /* Seconds, < 0 for a jog that runs until it is stopped */
+    double accel;       /* Signed, steps/sec/sec */
+} simSegment;
+
+typedef enum {simMoveNone, simMoveAbs, simMoveRel, simMoveHome} simMoveType;
+
+typedef struct {
+    ELLNODE node;               /* Must be first, list of all simulated axes */
+    axisRecord *pmr;
+    CALLBACK processCallback;
+
+    /* Settings from build_trans(), raw units */
+    double velocity;
+    double velBase;
+    double accel;
+    double highLimit;
+    double lowLimit;
+    simMoveType moveType;       /* Move to start on GO */
+    double moveParam;
+
+    /* Motion, protected by simLock */
+    epicsTimeStamp startTime;   /* Start of the profile */
+    double startPosition;
+    double startVelocity;
+    simSegment segments[SIM_MAX_SEGMENTS];
+    int numSegments;
+    int hasEnd;                 /* The profile ends at endPosition */
+    double endPosition;
+    int moving;
+    int homing;
+    double position;            /* At the latest tick */
+    double velocityNow;
+    epicsUInt32 status;
+    int processQueued;
+
+    /* Copied from the above by processCallback, protected by the record lock */
+    double updatePosition;
+    double updateVelocity;
+    epicsUInt32 updateStatus;
+    int needUpdate;
+    unsigned long updates;
+} axisSimPvt;
+
+static ELLLIST simList = ELLLIST_INIT;
+static epicsMutexId simLock;
+static epicsThreadId simThread;
+static double simPeriod = 0.1;
+static double simLatency = 0.;
+static double simJitter = 0.;
+
+/* Counters of the timer thread, protected by simLock */
+static unsigned long simTicks;
+static unsigned long simQueued;
+static unsigned long simMerged;
+static double simTickMax;       /* Longest tick, seconds */
+static int simMovingMax;        /* Most axes moving in one tick */
+
+static void processCallback(CALLBACK *);
+
+/* Evaluate the profile of pPvt at now, returns 1 when it has ended */
+static int sim_evaluate(axisSimPvt *pPvt, const epicsTimeStamp *now,
+                        double *position, double *velocity)
+{
+    double t = epicsTimeDiffInSeconds(now, &pPvt->startTime);
+    double p = pPvt->startPosition;
+    double v = pPvt->startVelocity;
+    int i;
+
+    if (t < 0.) t = 0.;
+    for (i = 0; i < pPvt->numSegments; i++) {
+        simSegment *pSeg = &pPvt->segments[i];
+        double dt = pSeg->duration;
+
+        if (dt < 0. || t < dt) {
+            *position = p + v * t + 0.5 * pSeg->accel * t * t;
+            *velocity = v + pSeg->accel * t;
+            return 0;
+        }
+        p += v * dt + 0.5 * pSeg->accel * dt * dt;
+        v += pSeg->accel * dt;
+        t -= dt;
+    }
+    /* Without the rounding errors of the segments */
+    *position = pPvt->hasEnd ? pPvt->endPosition : p;
+    *velocity = 0.;
+    return 1;
+}
+
+static void sim_add_segment(axisSimPvt *pPvt, double duration, double accel)
+{
+    if (duration == 0.) return;
+    pPvt->segments[pPvt->numSegments].duration = duration;
+    pPvt->segments[pPvt->numSegments].accel = accel;
+    pPvt->numSegments++;
+}
+
+/* Restart the profile at the current position and velocity */
+static void sim_restart(axisSimPvt *pPvt, const epicsTimeStamp *now)
+{
+    if (pPvt->moving)
+        sim_evaluate(pPvt, now, &pPvt->position, &pPvt->velocityNow);
+    else
+        pPvt->velocityNow = 0.;
+    pPvt->startTime = *now;
+    pPvt->startPosition = pPvt->position;
+    pPvt->startVelocity = pPvt->velocityNow;
+    pPvt->numSegments = 0;
+    pPvt->hasEnd = 0;
+}
+
+/* Decelerate from the start velocity to zero */
+static void sim_plan_stop(axisSimPvt *pPvt)
+{
+    double v = pPvt->startVelocity;
+
+    if (v != 0. && pPvt->accel > 0.)
+        sim_add_segment(pPvt, fabs(v) / pPvt->accel, v > 0. ? -pPvt->accel : pPvt->accel);
+    else
+        pPvt->startVelocity = 0.;
+}
+
+/* Move from the start of the profile to target, reversing first if needed */
+static void sim_plan_move(axisSimPvt *pPvt, double target)
+{
+    double accel = pPvt->accel;
+    double vmax = pPvt->velocity > pPvt->velBase ? pPvt->velocity : pPvt->velBase;
+    double vbase = pPvt->velBase;
+    double p = pPvt->startPosition;
+    double v = pPvt->startVelocity;
+    double dir, dist, v0, vpeak, dacc, ddec, dt;
+
+    pPvt->hasEnd = 1;
+    pPvt->endPosition = target;
+    if (vmax <= 0.) vmax = 1.;
+    if (vbase > vmax) vbase = vmax;
+    dir = (target >= p) ? 1. : -1.;
+    if (accel <= 0.) {
+        /* No acceleration, jump to the velocity */
+        pPvt->startVelocity = dir * vmax;
+        sim_add_segment(pPvt, fabs(target - p) / vmax, 0.);
+        return;
+    }
+    if (v * dir < 0.) {
+        /* Moving the other way, stop first */
+        dt = fabs(v) / accel;
+        sim_add_segment(pPvt, dt, -v / dt);
+        p += 0.5 * v * dt;
+        v = 0.;
+        dir = (target >= p) ? 1. : -1.;
+    }
+    dist = fabs(target - p);
+    if (dist == 0.) return;
+    /* The velocity can only jump to VBAS at the start of the profile */
+    if (pPvt->numSegments == 0) {
+        v0 = fabs(v) > vbase ? fabs(v) : vbase;
+        pPvt->startVelocity = dir * v0;
+    } else {
+        v0 = 0.;
+    }
+    /* Peak velocity of a triangle from v0 up and down to vbase */
+    vpeak = sqrt(accel * dist + 0.5 * (v0 * v0 + vbase * vbase));
+    if (vpeak < v0) {
+        /* Too close to stop with accel, stop harder */
+        dt = 2. * dist / (v0 + vbase);
+        sim_add_segment(pPvt, dt, dir * (vbase - v0) / dt);
+        return;
+    }
+    if (vpeak > vmax) vpeak = vmax;
+    dacc = (vpeak * vpeak - v0 * v0) / (2. * accel);
+    ddec = (vpeak * vpeak - vbase * vbase) / (2. * accel);
+    sim_add_segment(pPvt, (vpeak - v0) / accel, dir * accel);
+    if (dist > dacc + ddec)
+        sim_add_segment(pPvt, (dist - dacc - ddec) / vpeak, 0.);
+    sim_add_segment(pPvt, (vpeak - vbase) / accel, -dir * accel);
+}
+
+/* Run with velocity until stopped */
+static void sim_plan_jog(axisSimPvt *pPvt, double velocity)
+{
+    double v = pPvt->startVelocity;
+
+    if (pPvt->accel > 0. && v != velocity)
+        sim_add_segment(pPvt, fabs(velocity - v) / pPvt->accel,
+                        velocity > v ? pPvt->accel : -pPvt->accel);
+    else
+        pPvt->startVelocity = velocity;
+    sim_add_segment(pPvt, -1., 0.);
+}
+
+/* Queue a process of the record, called with simLock held */
+static void sim_queue(axisSimPvt *pPvt)
+{
+    double delay = simLatency;
+
+    if (pPvt->processQueued) {
+        simMerged++;
+        return;
+    }
+    if (simJitter > 0.)
+        delay += simJitter * rand() / (double)RAND_MAX;
+    pPvt->processQueued = 1;
+    simQueued++;
+    callbackRequestDelayed(&pPvt->processCallback, delay);
+}
+
+/* Update position and status at now, called with simLock held */
+static void sim_update(axisSimPvt *pPvt, const epicsTimeStamp *now)
+{
+    epicsUInt32 status = pPvt->status;
+    int limitsOn = pPvt->highLimit > pPvt->lowLimit;
+    int ended = 1;
+
+    if (pPvt->moving)
+        ended = sim_evaluate(pPvt, now, &pPvt->position, &pPvt->velocityNow);
+    else
+        pPvt->velocityNow = 0.;
+
+    status &= ~(STATUS_BIT_HIGH_LIMIT | STATUS_BIT_LOW_LIMIT | STATUS_BIT_AT_HOME);
+    if (limitsOn && pPvt->position >= pPvt->highLimit) {
+        status |= STATUS_BIT_HIGH_LIMIT;
+        if (pPvt->moving && pPvt->velocityNow > 0.) {
+            pPvt->position = pPvt->highLimit;
+            ended = 1;
+        }
+    }
+    if (limitsOn && pPvt->position <= pPvt->lowLimit) {
+        status |= STATUS_BIT_LOW_LIMIT;
+        if (pPvt->moving && pPvt->velocityNow < 0.) {
+            pPvt->position = pPvt->lowLimit;
+            ended = 1;
+        }
+    }
+    if (pPvt->moving && ended) {
+        pPvt->moving = 0;
+        pPvt->velocityNow = 0.;
+        if (pPvt->homing && pPvt->position == 0.)
+            status |= STATUS_BIT_HOMED;
+        pPvt->homing = 0;
+    }
+    if (pPvt->position == 0.)
+        status |= STATUS_BIT_AT_HOME;
+    if (pPvt->velocityNow > 0.)
+        status |= STATUS_BIT_DIRECTION;
+    else if (pPvt->velocityNow < 0.)
+        status &= ~STATUS_BIT_DIRECTION;
+    if (pPvt->moving)
+        status = (status | STATUS_BIT_MOVING) & ~STATUS_BIT_DONE;
+    else
+        status = (status | STATUS_BIT_DONE) & ~STATUS_BIT_MOVING;
+    pPvt->status = status;
+}
+
+static void simThreadFunc(void *arg)
+{
+    axisSimPvt *pPvt;
+    epicsTimeStamp now, end;
+    double tick;
+    int moving;
+
+    while (1) {
+        epicsMutexMustLock(simLock);
+        epicsTimeGetCurrent(&now);
+        moving = 0;
+        for (pPvt = (axisSimPvt *)ellFirst(&simList); pPvt;
+             pPvt = (axisSimPvt *)ellNext(&pPvt->node)) {
+            if (!pPvt->moving) continue;
+            moving++;
+            sim_update(pPvt, &now);
+            sim_queue(pPvt);
+        }
+        simTicks++;
+        if (moving > simMovingMax) simMovingMax = moving;
+        epicsTimeGetCurrent(&end);
+        tick = epicsTimeDiffInSeconds(&end, &now);
+        if (tick > simTickMax) simTickMax = tick;
+        epicsMutexUnlock(simLock);
+        epicsThreadSleep(simPeriod > tick ? simPeriod - tick : 0.);
+    }
+}
+
+static long init(int after)
+{
+    if (after == 0 && !simLock)
+        simLock = epicsMutexMustCreate();
+    if (after == 1 && ellCount(&simList) && !simThread)
+        simThread = epicsThreadMustCreate("devAxisSim", epicsThreadPriorityMedium,
+                                          epicsThreadGetStackSize(epicsThreadStackSmall),
+                                          simThreadFunc, NULL);
+    return 0;
+}
+
+static long init_record(struct axisRecord *pmr)
+{
+    axisSimPvt *pPvt;
+
+    if (pmr->out.type != INST_IO) {
+        recGblRecordError(S_dev_badOutType, (void *)pmr,
+                          "devAxisSim::init_record, OUT is not INST_IO");
+        return S_dev_badOutType;
+    }
+    if (!simLock)
+        simLock = epicsMutexMustCreate();
+    pPvt = callocMustSucceed(1, sizeof(*pPvt), "devAxisSim::init_record");
+    pPvt->pmr = pmr;
+    pPvt->status = STATUS_BIT_DONE | STATUS_BIT_POWERED;
+    pPvt->updateStatus = pPvt->status;
+    pPvt->needUpdate = 1;
+    pmr->mflg = MF_RETARGET;
+    callbackSetCallback(processCallback, &pPvt->processCallback);
+    callbackSetUser(pPvt, &pPvt->processCallback);
+    callbackSetPriority(pmr->prio, &pPvt->processCallback);
+    pmr->dpvt = pPvt;
+
+    epicsMutexMustLock(simLock);
+    ellAdd(&simList, &pPvt->node);
+    epicsMutexUnlock(simLock);
+    return 0;
+}
+
+static void processCallback(CALLBACK *pcallback)
+{
+    axisSimPvt *pPvt;
+    axisRecord *pmr;
+
+    callbackGetUser(pPvt, pcallback);
+    pmr = pPvt->pmr;
+
+    dbScanLock((dbCommon *)pmr);
+    epicsMutexMustLock(simLock);
+    pPvt->updatePosition = pPvt->position;
+    pPvt->updateVelocity = pPvt->velocityNow;
+    pPvt->updateStatus = pPvt->status;
+    pPvt->processQueued = 0;
+    epicsMutexUnlock(simLock);
+    pPvt->needUpdate = 1;
+    dbProcess((dbCommon *)pmr);
+    dbScanUnlock((dbCommon *)pmr);
+}
+
+static CALLBACK_VALUE update_values(struct axisRecord *pmr)
+{
+    axisSimPvt *pPvt = (axisSimPvt *)pmr->dpvt;
+    epicsInt32 rawvalue;
+
+    if (!pPvt->needUpdate)
+        return NOTHING_DONE;
+
+    pmr->priv->readBack.position = pPvt->updatePosition;
+    pmr->priv->readBack.encoderPosition = pPvt->updatePosition;
+    rawvalue = (epicsInt32)floor(pPvt->updatePosition + 0.5);
+    if (pmr->rmp != rawvalue) {
+        pmr->rmp = rawvalue;
+        db_post_events(pmr, &pmr->rmp, DBE_VAL_LOG);
+    }
+    if (pmr->rep != rawvalue) {
+        pmr->rep = rawvalue;
+        db_post_events(pmr, &pmr->rep, DBE_VAL_LOG);
+    }
+    /* MSTA is posted by the record */
+    pmr->msta = pPvt->updateStatus;
+    rawvalue = (epicsInt32)floor(pPvt->updateVelocity);
+    if (pmr->rvel != rawvalue) {
+        pmr->rvel = rawvalue;
+        db_post_events(pmr, &pmr->rvel, DBE_VAL_LOG);
+    }
+    pPvt->updates++;
+    pPvt->needUpdate = 0;
+    return CALLBACK_DATA;
+}
+
+static long start_trans(struct axisRecord *pmr)
+{
+    return OK;
+}
+
+static RTN_STATUS build_trans(motor_cmnd command, double *param,
+                              struct axisRecord *pmr)
+{
+    axisSimPvt *pPvt = (axisSimPvt *)pmr->dpvt;
+    epicsTimeStamp now;
+    RTN_STATUS rtnind = OK;
+
+    epicsTimeGetCurrent(&now);
+    epicsMutexMustLock(simLock);
+    switch (command) {
+        case MOVE_ABS:
+            pPvt->moveType = simMoveAbs;
+            pPvt->moveParam = *param;
+            break;
+        case MOVE_REL:
+            pPvt->moveType = simMoveRel;
+            pPvt->moveParam = *param;
+            break;
+        case HOME_FOR:
+        case HOME_REV:
+            pPvt->moveType = simMoveHome;
+            break;
+        case SET_VELOCITY:
+            pPvt->velocity = fabs(*param);
+            break;
+        case SET_VEL_BASE:
+            pPvt->velBase = fabs(*param);
+            break;
+        case SET_ACCEL:
+            pPvt->accel = fabs(*param);
+            break;
+        case SET_HIGH_LIMIT:
+            pPvt->highLimit = *param;
+            break;
+        case SET_LOW_LIMIT:
+            pPvt->lowLimit = *param;
+            break;
+        case GO:
+            sim_restart(pPvt, &now);
+            switch (pPvt->moveType) {
+                case simMoveAbs:
+                    sim_plan_move(pPvt, pPvt->moveParam);
+                    break;
+                case simMoveRel:
+                    sim_plan_move(pPvt, pPvt->startPosition + pPvt->moveParam);
+                    break;
+                case simMoveHome:
+                    pPvt->homing = 1;
+                    pPvt->status &= ~STATUS_BIT_HOMED;
+                    sim_plan_move(pPvt, 0.);
+                    break;
+                default:
+                    break;
+            }
+            pPvt->moveType = simMoveNone;
+            pPvt->moving = 1;
+            sim_update(pPvt, &now);
+            sim_queue(pPvt);
+            break;
+        case JOG:
+        case JOG_VELOCITY:
+            sim_restart(pPvt, &now);
+            sim_plan_jog(pPvt, *param);
+            pPvt->moving = 1;
+            sim_update(pPvt, &now);
+            sim_queue(pPvt);
+            break;
+        case STOP_AXIS:
+            if (pPvt->moving) {
+                sim_restart(pPvt, &now);
+                sim_plan_stop(pPvt);
+                sim_update(pPvt, &now);
+            }
+            sim_queue(pPvt);
+            break;
+        case LOAD_POS:
+            sim_restart(pPvt, &now);
+            pPvt->moving = 0;
+            pPvt->position = *param;
+            sim_update(pPvt, &now);
+            sim_queue(pPvt);
+            break;
+        case GET_INFO:
+            sim_update(pPvt, &now);
+            sim_queue(pPvt);
+            break;
+        case RETARGET:
+            /* Too late if the move is over, the record moves again */
+            if (!pPvt->moving || pPvt->homing) {
+                rtnind = ERROR;
+                break;
+            }
+            sim_restart(pPvt, &now);
+            sim_plan_move(pPvt, *param);
+            sim_update(pPvt, &now);
+            sim_queue(pPvt);
+            break;
+        case SET_BACKLASH:
+        case SET_RETRY:
+            /* The record does the approach and the retries itself */
+            rtnind = ERROR;
+            break;
+        case SET_ENC_RATIO:
+        case SET_PGAIN:
+        case SET_IGAIN:
+        case SET_DGAIN:
+        case ENABLE_TORQUE:
+        case DISABL_TORQUE:
+            break;
+        default:
+            errlogPrintf("devAxisSim::build_trans: %s: motor command %d not supported\n",
+                         pmr->name, command);
+            rtnind = ERROR;
+            break;
+    }
+    epicsMutexUnlock(simLock);
+    return rtnind;
+}
+
+static RTN_STATUS end_trans(struct axisRecord *pmr)
+{
+    return OK;
+}
+
+static long report(int level)
+{
+    axisSimPvt *pPvt;
+
+    if (!simLock) return 0;
+    epicsMutexMustLock(simLock);
+    printf("    %d axes, period=%g latency=%g jitter=%g\n",
+           ellCount(&simList), simPeriod, simLatency, simJitter);
+    if (level >= 1) {
+        printf("    ticks=%lu queued=%lu merged=%lu longest tick=%g most moving=%d\n",
+               simTicks, simQueued, simMerged, simTickMax, simMovingMax);
+    }
+    if (level >= 2) {
+        for (pPvt = (axisSimPvt *)ellFirst(&simList); pPvt;
+             pPvt = (axisSimPvt *)ellNext(&pPvt->node)) {
+            printf("    %s position=%g velocity=%g status=0x%x updates=%lu\n",
+                   pPvt->pmr->name, pPvt->position, pPvt->velocityNow,
+                   pPvt->status, pPvt->updates);
+        }
+    }
+    epicsMutexUnlock(simLock);
+    return 0;
+}
+
+static void devAxisSimConfig(double period, double latency, double jitter)
+{
+    if (period <= 0. || latency < 0. || jitter < 0.) {
+        printf("devAxisSimConfig: period must be > 0, latency and jitter >= 0\n");
+        return;
+    }
+    simPeriod = period;
+    simLatency = latency;
+    simJitter = jitter;
+}
+
+static const iocshArg simConfigArg0 = {"Period (sec)", iocshArgDouble};
+static const iocshArg simConfigArg1 = {"Latency (sec)", iocshArgDouble};
+static const iocshArg simConfigArg2 = {"Jitter (sec)", iocshArgDouble};
+static const iocshArg * const simConfigArgs[3] = {&simConfigArg0, &simConfigArg1,
+                                                  &simConfigArg2};
+static const iocshFuncDef simConfigDef = {"devAxisSimConfig", 3, simConfigArgs};
+
+static void simConfigCallFunc(const iocshArgBuf *args)
+{
+    devAxisSimConfig(args[0].dval, args[1].dval, args[2].dval);
+}
+
+static void devAxisSimRegister(void)
+{
+    iocshRegister(&simConfigDef, simConfigCallFunc);
+}
+epicsExportRegistrar(devAxisSimRegister);
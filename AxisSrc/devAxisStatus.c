@@ -0,0 +1,388 @@
+/*
+ * devAxisStatus.c
+ *
+ * Read only device support for ai, bi and longin records that show the
+ * MotorStatus of an asynAxisController axis.
+ *
+ * All records of an axis share one subscription to the MOTOR_STATUS
+ * generic pointer interrupt. It is separate from the one of devAxisAsyn, so
+ * an axis with an axis record and status records gets each status twice.
+ * Each status callback stores the MotorStatus and scans the records with
+ * SCAN="I/O Intr", which pick their field out of it. There is no polling
+ * and no parameter lookup per record.
+ *
+ * INP is "@asyn(port,axis)FIELD" with DTYP "asynAxisStatus".
+ * FIELD is one of
+ *   POSITION, ENCODER_POSITION, VELOCITY  ai, raw units times ASLO plus AOFF
+ *   STATUS                                longin, the whole status word
+ *   DIRECTION, DONE, HIGH_LIMIT, AT_HOME, SLIP, POWERED, FOLLOWING_ERROR,
+ *   HOME, HAS_ENCODER, PROBLEM, MOVING, GAIN_SUPPORT, COMMS_ERROR,
+ *   LOW_LIMIT, HOMED, ESTIMATED           bi or longin, one bit of the status
+ */
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <dbAccess.h>
+#include <recGbl.h>
+#include <recSup.h>
+#include <devSup.h>
+#include <alarm.h>
+#include <errlog.h>
+#include <dbScan.h>
+#include <epicsMutex.h>
+#include <epicsString.h>
+#include <epicsTime.h>
+#include <ellLib.h>
+#include <cantProceed.h>
+#include <aiRecord.h>
+#include <biRecord.h>
+#include <longinRecord.h>
+
+#include <asynDriver.h>
+#include <asynDrvUser.h>
+#include <asynGenericPointer.h>
+#include <asynEpicsUtils.h>
+
+#include "epicsExport.h"
+#include "asynAxisController.h"
+
+typedef enum {
+    fieldPosition,
+    fieldEncoderPosition,
+    fieldVelocity,
+    fieldStatus,
+    fieldStatusBit
+} statusFieldType;
+
+typedef struct {
+    const char *name;
+    statusFieldType type;
+    epicsUInt32 bit;
+} statusField;
+
+static const statusField statusFields[] = {
+    {"POSITION",         fieldPosition,        0},
+    {"ENCODER_POSITION", fieldEncoderPosition, 0},
+    {"VELOCITY",         fieldVelocity,        0},
+    {"STATUS",           fieldStatus,          0},
+    {"DIRECTION",        fieldStatusBit, STATUS_BIT_DIRECTION},
+    {"DONE",             fieldStatusBit, STATUS_BIT_DONE},
+    {"HIGH_LIMIT",       fieldStatusBit, STATUS_BIT_HIGH_LIMIT},
+    {"AT_HOME",          fieldStatusBit, STATUS_BIT_AT_HOME},
+    {"SLIP",             fieldStatusBit, STATUS_BIT_SLIP},
+    {"POWERED",          fieldStatusBit, STATUS_BIT_POWERED},
+    {"FOLLOWING_ERROR",  fieldStatusBit, STATUS_BIT_FOLLOWING_ERROR},
+    {"HOME",             fieldStatusBit, STATUS_BIT_HOME},
+    {"HAS_ENCODER",      fieldStatusBit, STATUS_BIT_HAS_ENCODER},
+    {"PROBLEM",          fieldStatusBit, STATUS_BIT_PROBLEM},
+    {"MOVING",           fieldStatusBit, STATUS_BIT_MOVING},
+    {"GAIN_SUPPORT",     fieldStatusBit, STATUS_BIT_GAIN_SUPPORT},
+    {"COMMS_ERROR",      fieldStatusBit, STATUS_BIT_COMMS_ERROR},
+    {"LOW_LIMIT",        fieldStatusBit, STATUS_BIT_LOW_LIMIT},
+    {"HOMED",            fieldStatusBit, STATUS_BIT_HOMED},
+    {"ESTIMATED",        fieldStatusBit, STATUS_BIT_ESTIMATED},
+};
+
+/* One subscription per axis, shared by all records of the axis */
+typedef struct
+{
+    ELLNODE node;       /* Must be first, list of all subscriptions */
+    char *portName;
+    int axis;
+    asynUser *pasynUser;
+    void *registrarPvt;
+    epicsMutexId lock;
+    MotorStatus status; /* The latest status */
+    epicsTimeStamp time; /* When it came */
+    int valid;          /* A status has come */
+    IOSCANPVT ioScanPvt;
+    int numRecords;
+    unsigned long callbacks;
+} axisStatusSub;
+
+typedef struct
+{
+    axisStatusSub *pSub;
+    const statusField *pField;
+} axisStatusPvt;
+
+/* Only changed by init_record, which runs in one thread */
+static ELLLIST axisStatusSubList = ELLLIST_INIT;
+
+static void statusCallback(void *userPvt, asynUser *pasynUser, void *pointer)
+{
+    axisStatusSub *pSub = (axisStatusSub *)userPvt;
+
+    epicsMutexMustLock(pSub->lock);
+    memcpy(&pSub->status, pointer, sizeof(pSub->status));
+    epicsTimeGetCurrent(&pSub->time);
+    pSub->valid = 1;
+    pSub->callbacks++;
+    epicsMutexUnlock(pSub->lock);
+    scanIoRequest(pSub->ioScanPvt);
+}
+
+/* Find the subscription for an axis, subscribe if there is none yet */
+static axisStatusSub *get_sub(const char *portName, int axis, const char *recName)
+{
+    axisStatusSub *pSub;
+    asynInterface *pasynInterface;
+    asynGenericPointer *pasynGenericPointer;
+    void *asynGenericPointerPvt;
+    asynUser *pasynUser;
+
+    for (pSub = (axisStatusSub *)ellFirst(&axisStatusSubList); pSub;
+         pSub = (axisStatusSub *)ellNext(&pSub->node)) {
+        if ((pSub->axis == axis) && !strcmp(pSub->portName, portName))
+            return pSub;
+    }
+
+    pSub = callocMustSucceed(1, sizeof(axisStatusSub), "devAxisStatus get_sub()");
+    pasynUser = pasynManager->createAsynUser(0, 0);
+    pSub->pasynUser = pasynUser;
+    if (pasynManager->connectDevice(pasynUser, portName, axis) != asynSuccess) {
+        errlogPrintf("devAxisStatus::get_sub %s connectDevice failed to %s\n",
+                     recName, portName);
+        goto bad;
+    }
+    pasynInterface = pasynManager->findInterface(pasynUser, asynDrvUserType, 1);
+    if (!pasynInterface ||
+        ((asynDrvUser *)pasynInterface->pinterface)->create(pasynInterface->drvPvt,
+            pasynUser, motorStatusString, NULL, NULL) != asynSuccess) {
+        errlogPrintf("devAxisStatus::get_sub %s port %s has no %s\n",
+                     recName, portName, motorStatusString);
+        goto bad;
+    }
+    pasynInterface = pasynManager->findInterface(pasynUser, asynGenericPointerType, 1);
+    if (!pasynInterface) {
+        errlogPrintf("devAxisStatus::get_sub %s find genericPointer interface failed\n",
+                     recName);
+        goto bad;
+    }
+    pasynGenericPointer = (asynGenericPointer *)pasynInterface->pinterface;
+    asynGenericPointerPvt = pasynInterface->drvPvt;
+
+    pSub->portName = epicsStrDup(portName);
+    pSub->axis = axis;
+    pSub->lock = epicsMutexMustCreate();
+    scanIoInit(&pSub->ioScanPvt);
+
+    /* Initial value, fails if the driver has not polled the axis yet */
+    if (pasynGenericPointer->read(asynGenericPointerPvt, pasynUser,
+                                  &pSub->status) == asynSuccess) {
+        epicsTimeGetCurrent(&pSub->time);
+        pSub->valid = 1;
+    }
+    if (pasynGenericPointer->registerInterruptUser(asynGenericPointerPvt, pasynUser,
+            statusCallback, pSub, &pSub->registrarPvt) != asynSuccess) {
+        errlogPrintf("devAxisStatus::get_sub %s registerInterruptUser failed, %s\n",
+                     recName, pasynUser->errorMessage);
+        goto bad;
+    }
+    ellAdd(&axisStatusSubList, &pSub->node);
+    return pSub;
+
+bad:
+    pasynManager->freeAsynUser(pasynUser);
+    free(pSub);
+    return NULL;
+}
+
+static long init_common(dbCommon *prec, DBLINK *plink, int bitOnly)
+{
+    axisStatusPvt *pPvt;
+    asynUser *pasynUser;
+    char *port, *userParam;
+    int axis;
+    size_t i;
+
+    pasynUser = pasynManager->createAsynUser(0, 0);
+    if (pasynEpicsUtils->parseLink(pasynUser, plink, &port, &axis, &userParam) != asynSuccess) {
+        errlogPrintf("devAxisStatus::init_record %s bad link %s\n",
+                     prec->name, pasynUser->errorMessage);
+        pasynManager->freeAsynUser(pasynUser);
+        goto bad;
+    }
+
+    pPvt = callocMustSucceed(1, sizeof(axisStatusPvt), "devAxisStatus init_record()");
+    for (i = 0; i < NELEMENTS(statusFields); i++) {
+        if (userParam && !strcmp(userParam, statusFields[i].name)) {
+            pPvt->pField = &statusFields[i];
+            break;
+        }
+    }
+    if (!pPvt->pField ||
+        (bitOnly && (pPvt->pField->type != fieldStatusBit))) {
+        errlogPrintf("devAxisStatus::init_record %s unknown field %s\n",
+                     prec->name, userParam ? userParam : "");
+        goto bad_pvt;
+    }
+    pPvt->pSub = get_sub(port, axis, prec->name);
+    pasynManager->freeAsynUser(pasynUser);
+    if (!pPvt->pSub)
+        goto bad_pvt_freed;
+    pPvt->pSub->numRecords++;
+    prec->dpvt = pPvt;
+    return 0;
+
+bad_pvt:
+    pasynManager->freeAsynUser(pasynUser);
+bad_pvt_freed:
+    free(pPvt);
+bad:
+    prec->pact = 1;
+    return -1;
+}
+
+static long get_ioint_info(int cmd, dbCommon *prec, IOSCANPVT *ppvt)
+{
+    axisStatusPvt *pPvt = (axisStatusPvt *)prec->dpvt;
+
+    if (!pPvt) return -1;
+    *ppvt = pPvt->pSub->ioScanPvt;
+    return 0;
+}
+
+/* Copy the field of the latest status, returns -1 if there is none yet */
+static int read_field(dbCommon *prec, double *pvalue, epicsUInt32 *pword)
+{
+    axisStatusPvt *pPvt = (axisStatusPvt *)prec->dpvt;
+    axisStatusSub *pSub = pPvt->pSub;
+    int valid;
+
+    epicsMutexMustLock(pSub->lock);
+    valid = pSub->valid;
+    switch (pPvt->pField->type) {
+        case fieldPosition:        *pvalue = pSub->status.position;        break;
+        case fieldEncoderPosition: *pvalue = pSub->status.encoderPosition; break;
+        case fieldVelocity:        *pvalue = pSub->status.velocity;        break;
+        case fieldStatus:          *pword = pSub->status.status;           break;
+        case fieldStatusBit:
+            *pword = (pSub->status.status & pPvt->pField->bit) ? 1 : 0;
+            break;
+    }
+    if (prec->tse == epicsTimeEventDeviceTime)
+        prec->time = pSub->time;
+    epicsMutexUnlock(pSub->lock);
+
+    if (!valid) {
+        recGblSetSevr(prec, READ_ALARM, INVALID_ALARM);
+        return -1;
+    }
+    return 0;
+}
+
+static long init_ai(aiRecord *prec)
+{
+    return init_common((dbCommon *)prec, &prec->inp, 0);
+}
+
+static long read_ai(aiRecord *prec)
+{
+    double value = 0.;
+    epicsUInt32 word = 0;
+
+    if (read_field((dbCommon *)prec, &value, &word)) return 2;
+    if (((axisStatusPvt *)prec->dpvt)->pField->type >= fieldStatus)
+        value = word;
+    if (prec->aslo != 0.0) value *= prec->aslo;
+    value += prec->aoff;
+    prec->val = value;
+    prec->udf = 0;
+    return 2; /* Don't convert */
+}
+
+static long init_bi(biRecord *prec)
+{
+    return init_common((dbCommon *)prec, &prec->inp, 1);
+}
+
+static long read_bi(biRecord *prec)
+{
+    double value = 0.;
+    epicsUInt32 word = 0;
+
+    if (read_field((dbCommon *)prec, &value, &word)) return 2;
+    prec->val = word ? 1 : 0;
+    prec->udf = 0;
+    return 2; /* Don't convert */
+}
+
+static long init_li(longinRecord *prec)
+{
+    return init_common((dbCommon *)prec, &prec->inp, 0);
+}
+
+static long read_li(longinRecord *prec)
+{
+    double value = 0.;
+    epicsUInt32 word = 0;
+
+    if (read_field((dbCommon *)prec, &value, &word)) return 0;
+    if (((axisStatusPvt *)prec->dpvt)->pField->type < fieldStatus)
+        prec->val = (epicsInt32)value;
+    else
+        prec->val = (epicsInt32)word;
+    prec->udf = 0;
+    return 0;
+}
+
+static long report(int level)
+{
+    axisStatusSub *pSub;
+
+    printf("    %d axes subscribed\n", ellCount(&axisStatusSubList));
+    if (level < 1) return 0;
+    for (pSub = (axisStatusSub *)ellFirst(&axisStatusSubList); pSub;
+         pSub = (axisStatusSub *)ellNext(&pSub->node)) {
+        printf("    port %s axis %d records=%d callbacks=%lu\n",
+               pSub->portName, pSub->axis, pSub->numRecords, pSub->callbacks);
+    }
+    return 0;
+}
+
+typedef struct {
+    long number;
+    DEVSUPFUN report;
+    DEVSUPFUN init;
+    DEVSUPFUN init_record;
+    DEVSUPFUN get_ioint_info;
+    DEVSUPFUN read;
+    DEVSUPFUN special_linconv;
+} axisStatusDset;
+
+axisStatusDset devAxisStatusAi = {
+    6,
+    (DEVSUPFUN) report,
+    NULL,
+    (DEVSUPFUN) init_ai,
+    (DEVSUPFUN) get_ioint_info,
+    (DEVSUPFUN) read_ai,
+    NULL
+};
+epicsExportAddress(dset, devAxisStatusAi);
+
+axisStatusDset devAxisStatusBi = {
+    5,
+    NULL,
+    NULL,
+    (DEVSUPFUN) init_bi,
+    (DEVSUPFUN) get_ioint_info,
+    (DEVSUPFUN) read_bi,
+    NULL
+};
+epicsExportAddress(dset, devAxisStatusBi);
+
+axisStatusDset devAxisStatusLi = {
+    5,
+    NULL,
+    NULL,
+    (DEVSUPFUN) init_li,
+    (DEVSUPFUN) get_ioint_info,
+    (DEVSUPFUN) read_li,
+    NULL
+};
+epicsExportAddress(dset, devAxisStatusLi);
@@ -0,0 +1,99 @@
+/*
+ * axisEngineBench.cc
+ *
+ * Time of process() for a position update during a move, on the readback
+ * only path and on the full path of the motion logic.
+ *
+ * Both runs feed the same updates to a moving record.  For the full path
+ * every update also toggles the home switch bit of MSTA, which nothing in
+ * a move depends on, so that readbackOnlyUpdate() says no.  The IOC is the
+ * one of axisTestSim, monitors are only counted: the times are those of
+ * the motion logic alone.
+ *
+ * Usage: axisEngineBench [updates [maxRatio]]
+ * With maxRatio the readback only path must take at most that fraction of
+ * the time of the full path.  Run by hand, timings don't belong in runtests.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+
+#include <epicsTime.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "axisTestSim.h"
+
+#define BENCH_ROUNDS 10
+
+/* Seconds per process() for updates to the moving record */
+static double timeUpdates(axisRecord *pmr, long updates, int toggle)
+{
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+    epicsTimeStamp start, end;
+    msta_field msta;
+    long i;
+
+    epicsTimeGetCurrent(&start);
+    for (i = 0; i < updates; i++)
+    {
+        pmotor->position += 1.0;
+        if (toggle)
+        {
+            msta.All = pmotor->status;
+            msta.Bits.RA_HOME = !msta.Bits.RA_HOME;
+            pmotor->status = msta.All;
+        }
+        pmotor->needUpdate = 1;
+        axisTestProcess(pmr);
+    }
+    epicsTimeGetCurrent(&end);
+    return epicsTimeDiffInSeconds(&end, &start) / updates;
+}
+
+MAIN(axisEngineBench)
+{
+    long updates = (argc > 1) ? atol(argv[1]) : 10000000;
+    double maxRatio = (argc > 2) ? atof(argv[2]) : 0.0;
+    axisRecord *pmr;
+    axisTestMotor *pmotor;
+    double fast, full, t;
+    int i;
+
+    testPlan(maxRatio > 0.0 ? 3 : 2);
+    pmr = axisTestCreate("bench");
+    axisTestInit(pmr);
+    pmotor = axisTestGetMotor(pmr);
+
+    /* A move that outlasts both runs; the updates move the motor */
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 1e6);
+    axisTestRun(axisTestTick);
+    pmotor->velocity = 0.0;
+
+    /* Alternate the paths, the best round of each counts */
+    fast = full = HUGE_VAL;
+    for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+        t = timeUpdates(pmr, updates / BENCH_ROUNDS, 0);
+        if (t < fast)
+            fast = t;
+        if (i == 0)
+            testOk(!pmr->dmov && pmr->rrbv == (epicsInt32) pmotor->position,
+                   "readback only path: RRBV %d follows the motor", pmr->rrbv);
+        t = timeUpdates(pmr, updates / BENCH_ROUNDS, 1);
+        if (t < full)
+            full = t;
+        if (i == 0)
+            testOk(!pmr->dmov && pmr->rrbv == (epicsInt32) pmotor->position,
+                   "full path: RRBV %d follows the motor", pmr->rrbv);
+    }
+
+    testDiag("%ld updates in %d rounds", updates, BENCH_ROUNDS);
+    testDiag("readback only path %.0f ns per process()", fast * 1e9);
+    testDiag("full path          %.0f ns per process()", full * 1e9);
+    testDiag("ratio              %.2f", fast / full);
+    if (maxRatio > 0.0)
+        testOk(fast / full <= maxRatio, "ratio %.2f at most %.2f",
+               fast / full, maxRatio);
+    return testDone();
+}
@@ -0,0 +1,293 @@
+/*
+ * axisEngineTest.cc
+ *
+ * Tests of the motion logic of the axis record, run on the simulated IOC
+ * and motor of axisTestSim.
+ */
+
+#include <math.h>
+
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "axisTestSim.h"
+#include "axisDevSup.h"
+
+/* Move to value and wait for DMOV */
+static int moveTo(axisRecord *pmr, double value, double timeout)
+{
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, value);
+    return axisTestWaitDone(pmr, timeout);
+}
+
+static axisRecord *createInit(const char *name)
+{
+    axisRecord *pmr = axisTestCreate(name);
+
+    axisTestInit(pmr);
+    return pmr;
+}
+
+static void testMove(void)
+{
+    axisRecord *pmr = createInit("move");
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+    unsigned long fwdLinks = axisTestCount.fwdLinks;
+
+    testDiag("Move");
+    testOk1(pmr->dmov && pmr->rbv == 0.0);
+    testOk(moveTo(pmr, 1.0, 5.0), "move done");
+    testOk(fabs(pmr->rbv - 1.0) < pmr->rdbd, "RBV %g at VAL", pmr->rbv);
+    testOk(pmotor->moves == 1, "%lu move", pmotor->moves);
+    testOk(axisTestCount.fwdLinks == fwdLinks + 1, "one forward link");
+    testOk1(!pmr->movn && pmr->mip == MIP_DONE && pmr->rcnt == 0);
+}
+
+static void testRetries(void)
+{
+    axisRecord *pmr = createInit("retry");
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+
+    testDiag("Retries");
+    pmotor->miss = 5;   /* 0.05, more than RDBD */
+    pmotor->misses = 1;
+    testOk(moveTo(pmr, 2.0, 10.0), "move done");
+    testOk(fabs(pmr->rbv - 2.0) < pmr->rdbd, "RBV %g at VAL", pmr->rbv);
+    testOk(pmotor->moves == 2 && pmr->rcnt == 1,
+           "%lu moves, RCNT %d", pmotor->moves, pmr->rcnt);
+    testOk1(!pmr->miss);
+
+    pmr->rtry = 3;
+    pmotor->misses = 10;
+    pmotor->moves = 0;
+    testOk(moveTo(pmr, 3.0, 10.0), "move done");
+    testOk(pmotor->moves == 4 && pmr->miss,
+           "%lu moves, MISS %d after RTRY retries", pmotor->moves, pmr->miss);
+}
+
+static void testBacklash(void)
+{
+    axisRecord *pmr = axisTestCreate("backlash");
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+
+    testDiag("Backlash");
+    pmr->bdst = 0.1;
+    axisTestInit(pmr);
+    testOk(moveTo(pmr, 2.0, 10.0), "move in the preferred direction done");
+    pmotor->moves = 0;
+    testOk(moveTo(pmr, 1.0, 10.0), "move against it done");
+    testOk(fabs(pmr->rbv - 1.0) < pmr->rdbd, "RBV %g at VAL", pmr->rbv);
+    testOk(pmotor->moves == 2, "%lu moves, the second takes out the backlash",
+           pmotor->moves);
+}
+
+static void testLimits(void)
+{
+    axisRecord *pmr = axisTestCreate("limits");
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+
+    testDiag("Soft and hard limits");
+    pmr->dhlm = 5.0;
+    pmr->dllm = -5.0;
+    pmotor->highLimit = 300;    /* 3.0 */
+    pmotor->lowLimit = -300;
+    axisTestInit(pmr);
+
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 6.0);
+    testOk(pmr->lvio && pmr->dmov, "LVIO for VAL beyond HLM");
+    testOk(pmr->val == 0.0 && pmotor->moves == 0, "VAL restored, no move");
+
+    testOk(moveTo(pmr, 4.0, 10.0), "move into the limit switch done");
+    testOk(pmr->hls && fabs(pmr->rbv - 3.0) < pmr->rdbd,
+           "HLS %d at RBV %g", pmr->hls, pmr->rbv);
+    testOk1(!pmr->lvio);
+    testOk(moveTo(pmr, 0.0, 10.0), "move off the limit switch done");
+    testOk1(!pmr->hls && fabs(pmr->rbv) < pmr->rdbd);
+}
+
+static void testStop(void)
+{
+    axisRecord *pmr = createInit("stop");
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+
+    testDiag("Stop");
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 10.0);
+    axisTestRun(0.5);
+    testOk1(!pmr->dmov && pmr->movn);
+    axisTestPut(pmr, axisRecordSTOP, &pmr->stop, (epicsInt16) 1);
+    testOk(axisTestWaitDone(pmr, 1.0), "stopped");
+    testOk(pmotor->stops == 1 && pmotor->moves == 1,
+           "%lu stop, no move after it", pmotor->stops);
+    testOk(pmr->rbv < 1.0 && pmr->val == pmr->rbv,
+           "VAL %g at RBV %g", pmr->val, pmr->rbv);
+}
+
+/* Time from the end of the move to DMOV */
+static double settleTime(axisRecord *pmr, double value)
+{
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+    double stopped;
+
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, value);
+    do {
+        axisTestRun(axisTestTick);
+    } while (pmotor->moving);
+    stopped = axisTestTime();
+    axisTestWaitDone(pmr, 5.0);
+    return axisTestTime() - stopped;
+}
+
+static void testSettle(void)
+{
+    axisRecord *pmr = axisTestCreate("settle");
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+    double t;
+
+    testDiag("DLY ended by SWIN and STIM");
+    pmr->dly = 1.0;
+    pmotor->ring = 1.5;     /* 0.015, within RDBD */
+    pmotor->ringTicks = 10;
+    axisTestInit(pmr);
+
+    t = settleTime(pmr, 1.0);
+    testOk(t >= 1.0, "without SWIN DMOV after DLY, %g s", t);
+
+    pmr->swin = 0.005;
+    pmr->stim = 0.1;
+    t = settleTime(pmr, 2.0);
+    testOk(t >= 0.1 && t < 0.5, "settled after %g s", t);
+    testOk(fabs(pmr->rbv - 2.0) < pmr->rdbd, "RBV %g at VAL", pmr->rbv);
+
+    /* Doesn't settle within DLY: DLY still ends it */
+    pmotor->ringTicks = 200;
+    t = settleTime(pmr, 3.0);
+    testOk(t >= 1.0 && t < 1.5, "DLY caps the settle time, %g s", t);
+}
+
+static void testRetarget(void)
+{
+    axisRecord *pmr = createInit("retarget");
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+    double here;
+    int done;
+
+    testDiag("New targets during a move");
+    pmotor->retarget = 1;
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 10.0);
+    axisTestRun(0.5);
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 3.0);
+    testOk(pmotor->retargets == 1 && pmotor->stops == 0,
+           "%lu retarget, no stop", pmotor->retargets);
+    /* Within SDBD of the target sent: not sent, later ones still are */
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 3.005);
+    axisTestRun(axisTestTick);
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 3.5);
+    testOk(pmotor->retargets == 2, "%lu retargets", pmotor->retargets);
+    done = axisTestWaitDone(pmr, 10.0);
+    testOk(done && fabs(pmr->rbv - 3.5) < pmr->rdbd, "RBV %g at VAL", pmr->rbv);
+
+    /* A new target at the current position is not within the deadband */
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 10.0);
+    axisTestRun(0.5);
+    here = pmr->rbv;
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, here);
+    done = axisTestWaitDone(pmr, 10.0);
+    testOk(done && fabs(pmr->rbv - here) < pmr->rdbd,
+           "RBV %g at VAL %g", pmr->rbv, here);
+    testOk(pmotor->moves == 2 && pmotor->retargets == 3,
+           "%lu moves, %lu retargets", pmotor->moves, pmotor->retargets);
+
+    /* Without RETARGET the new target is taken up after the move */
+    pmotor->retarget = 0;
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 6.0);
+    axisTestRun(0.5);
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 5.0);
+    done = axisTestWaitDone(pmr, 10.0);
+    testOk(done && fabs(pmr->rbv - 5.0) < pmr->rdbd, "RBV %g at VAL", pmr->rbv);
+    testOk(pmotor->moves == 4, "%lu moves", pmotor->moves);
+}
+
+/* Write a target each tick during a move.  The steps are larger than
+   SDBD, every one is a new target.  Returns the last. */
+static double writeTargets(axisRecord *pmr, double start, int writes)
+{
+    double value = start;
+    int i;
+
+    for (i = 0; i < writes; i++)
+    {
+        value += 0.02;
+        axisTestPut(pmr, axisRecordVAL, &pmr->val, value);
+        axisTestRun(axisTestTick);
+    }
+    return value;
+}
+
+static void testCoalesce(void)
+{
+    axisRecord *pmr = createInit("coalesce");
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+    double last;
+    int done;
+
+    testDiag("Target writes coalesced by CINT");
+    pmotor->retarget = 1;
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 10.0);
+    axisTestRun(0.1);
+    last = writeTargets(pmr, 5.0, 50);
+    done = axisTestWaitDone(pmr, 20.0);
+    testOk(pmotor->retargets == 50, "CINT 0: %lu retargets for 50 writes",
+           pmotor->retargets);
+    testOk(done && fabs(pmr->rbv - last) < pmr->rdbd,
+           "RBV %g at the last target %g", pmr->rbv, last);
+
+    /* Writes over 0.5 s: one retarget at the end of the first CINT, one
+       for the writes held back after it */
+    pmr->cint = 0.5;
+    pmotor->retargets = 0;
+    pmotor->moves = 0;
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 10.0);
+    axisTestRun(0.1);
+    last = writeTargets(pmr, 4.0, 50);
+    done = axisTestWaitDone(pmr, 20.0);
+    testOk(pmotor->retargets == 2, "CINT 0.5: %lu retargets for 50 writes",
+           pmotor->retargets);
+    testOk(done && fabs(pmr->rbv - last) < pmr->rdbd,
+           "RBV %g at the last target %g", pmr->rbv, last);
+    testOk(pmotor->moves == 1, "%lu move", pmotor->moves);
+}
+
+static void testReadbackOnly(void)
+{
+    axisRecord *pmr = createInit("readback");
+    axisTestMotor *pmotor = axisTestGetMotor(pmr);
+    int tracked = 1;
+
+    testDiag("Status updates during a move");
+    axisTestPut(pmr, axisRecordVAL, &pmr->val, 1.0);
+    while (pmotor->moving)
+    {
+        axisTestRun(axisTestTick);
+        if (pmr->rrbv != pmr->rmp ||
+            fabs(pmr->diff - (pmr->dval - pmr->drbv)) > 1e-9 ||
+            (pmotor->moving && pmr->dmov))
+            tracked = 0;
+    }
+    testOk(tracked, "RBV, DIFF and DMOV follow the motor");
+    testOk1(axisTestWaitDone(pmr, 1.0) && fabs(pmr->rbv - 1.0) < pmr->rdbd);
+}
+
+MAIN(axisEngineTest)
+{
+    testPlan(45);
+    testMove();
+    testRetries();
+    testBacklash();
+    testLimits();
+    testStop();
+    testRetarget();
+    testSettle();
+    testCoalesce();
+    testReadbackOnly();
+    return testDone();
+}
@@ -0,0 +1,468 @@
+/*
+ * axisTestSim.cc
+ *
+ * Simulated IOC and motor for axisEngine, see axisTestSim.h.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <alarm.h>
+#include <caeventmask.h>
+#include <callback.h>
+#include <epicsTime.h>
+#include <ellLib.h>
+#include <cantProceed.h>
+
+#include "axis_priv.h"
+#include "axisTestSim.h"
+#include "axisRecIoc.h"
+
+#define TEST_TIMERS 4           /* The timers of one axisEngine */
+
+typedef struct {
+    CALLBACK *pcallback;
+    double due;
+} axisTestTimer;
+
+typedef struct {
+    ELLNODE node;               /* Must be first */
+    axisRecord *pmr;
+    axisTestMotor motor;
+    axisTestTimer timers[TEST_TIMERS];
+    int scanQueued;             /* recIocScanOnce() */
+} axisTestPvt;
+
+axisTestCounters axisTestCount;
+double axisTestTick = 0.01;
+
+static ELLLIST testList;
+static double testTime;         /* Of the simulated clock */
+static const epicsTimeStamp testStart = {1000000000, 0};
+
+static CALLBACK_VALUE update_values(struct axisRecord *);
+static long start_trans(struct axisRecord *);
+static RTN_STATUS build_trans(motor_cmnd, double *, struct axisRecord *);
+static RTN_STATUS end_trans(struct axisRecord *);
+
+static struct motor_dset axisTestDset = {
+    {8, NULL, NULL, NULL, NULL},
+    update_values,
+    start_trans,
+    build_trans,
+    end_trans
+};
+
+/*****************************************************************************
+  The IOC
+*****************************************************************************/
+void recIocPostEvents(axisRecord *pmr, void *pfield, unsigned int mask)
+{
+    axisTestCount.posts++;
+}
+
+unsigned short recIocResetAlarms(axisRecord *pmr)
+{
+    unsigned short mask = 0;
+
+    if (pmr->sevr != pmr->nsev || pmr->stat != pmr->nsta)
+        mask = DBE_ALARM;
+    pmr->stat = pmr->nsta;
+    pmr->sevr = pmr->nsev;
+    pmr->nsta = 0;
+    pmr->nsev = 0;
+    return mask;
+}
+
+void recIocSetSevr(axisRecord *pmr, epicsEnum16 stat, epicsEnum16 sevr)
+{
+    if (pmr->nsev < sevr)
+    {
+        pmr->nsta = stat;
+        pmr->nsev = sevr;
+    }
+}
+
+long recIocGetLink(axisRecord *pmr, DBLINK *plink, double *pvalue)
+{
+    return 0;
+}
+
+long recIocPutLink(axisRecord *pmr, DBLINK *plink, double *pvalue)
+{
+    return 0;
+}
+
+void recIocMonitorReadback(axisRecord *pmr)
+{
+}
+
+long recIocGetReadback(axisRecord *pmr, double maxAge, double *pvalue)
+{
+    return -1;
+}
+
+void recIocRequestDelay(axisRecord *pmr, CALLBACK *pcallback, double delay)
+{
+    axisTestPvt *pPvt = (axisTestPvt *) pmr->dpvt;
+    axisTestTimer *pfree = NULL;
+    int i;
+
+    /* Like callbackRequestDelayed(), a running timer starts again */
+    for (i = 0; i < TEST_TIMERS; i++)
+    {
+        if (pPvt->timers[i].pcallback == pcallback)
+        {
+            pPvt->timers[i].due = testTime + delay;
+            return;
+        }
+        if (!pPvt->timers[i].pcallback && !pfree)
+            pfree = &pPvt->timers[i];
+    }
+    if (!pfree)
+        cantProceed("recIocRequestDelay: %s: too many timers\n", pmr->name);
+    pfree->pcallback = pcallback;
+    pfree->due = testTime + delay;
+}
+
+void recIocScanOnce(axisRecord *pmr)
+{
+    axisTestPvt *pPvt = (axisTestPvt *) pmr->dpvt;
+
+    pPvt->scanQueued = 1;
+}
+
+void recIocGetCurrentTime(axisRecord *pmr, epicsTimeStamp *pnow)
+{
+    *pnow = testStart;
+    epicsTimeAddSeconds(pnow, testTime);
+}
+
+void recIocGetTimeStamp(axisRecord *pmr)
+{
+    recIocGetCurrentTime(pmr, &pmr->time);
+}
+
+void recIocFwdLink(axisRecord *pmr)
+{
+    axisTestCount.fwdLinks++;
+}
+
+void recIocLock(axisRecord *pmr)
+{
+}
+
+void recIocUnlock(axisRecord *pmr)
+{
+}
+
+/*****************************************************************************
+  The motor
+*****************************************************************************/
+/* The position the record gets, with the ringing after a move */
+static double sim_readback(axisTestMotor *pmotor)
+{
+    if (pmotor->ringLeft <= 0)
+        return pmotor->position;
+    return pmotor->position + pmotor->ring *
+        ((pmotor->ringLeft & 1) ? 1 : -1) * pmotor->ringLeft / pmotor->ringTicks;
+}
+
+static void sim_status(axisTestMotor *pmotor, double direction)
+{
+    msta_field msta;
+
+    msta.All = pmotor->status;
+    msta.Bits.RA_DONE = !pmotor->moving;
+    msta.Bits.RA_MOVING = pmotor->moving;
+    if (direction != 0.0)
+        msta.Bits.RA_DIRECTION = (direction > 0.0);
+    msta.Bits.RA_PLUS_LS = (pmotor->highLimit > pmotor->lowLimit) &&
+                           (pmotor->position >= pmotor->highLimit);
+    msta.Bits.RA_MINUS_LS = (pmotor->highLimit > pmotor->lowLimit) &&
+                            (pmotor->position <= pmotor->lowLimit);
+    pmotor->status = msta.All;
+}
+
+static void sim_stop(axisTestMotor *pmotor)
+{
+    pmotor->moving = 0;
+    pmotor->jogVelocity = 0.0;
+    pmotor->ringLeft = pmotor->ringTicks;
+}
+
+static void sim_step(axisTestMotor *pmotor, double dt)
+{
+    double direction = 0.0;
+
+    if (pmotor->moving)
+    {
+        if (pmotor->jogVelocity != 0.0)
+        {
+            direction = pmotor->jogVelocity;
+            pmotor->position += pmotor->jogVelocity * dt;
+        }
+        else
+        {
+            double distance = pmotor->target - pmotor->position;
+            double step = pmotor->velocity * dt;
+
+            direction = distance;
+            if (fabs(distance) <= step)
+            {
+                pmotor->position = pmotor->target;
+                sim_stop(pmotor);
+            }
+            else
+                pmotor->position += (distance > 0.0) ? step : -step;
+        }
+        if (pmotor->highLimit > pmotor->lowLimit)
+        {
+            if (pmotor->position >= pmotor->highLimit && direction > 0.0)
+            {
+                pmotor->position = pmotor->highLimit;
+                sim_stop(pmotor);
+            }
+            else if (pmotor->position <= pmotor->lowLimit && direction < 0.0)
+            {
+                pmotor->position = pmotor->lowLimit;
+                sim_stop(pmotor);
+            }
+        }
+        pmotor->needUpdate = 1;
+    }
+    else if (pmotor->ringLeft > 0)
+    {
+        pmotor->ringLeft--;
+        pmotor->needUpdate = 1;
+    }
+    sim_status(pmotor, direction);
+}
+
+static void sim_start(axisTestMotor *pmotor, double target)
+{
+    if (pmotor->misses > 0)
+    {
+        pmotor->misses--;
+        target -= (target > pmotor->position) ? pmotor->miss : -pmotor->miss;
+    }
+    pmotor->target = target;
+    pmotor->jogVelocity = 0.0;
+    pmotor->moving = 1;
+    pmotor->ringLeft = 0;
+    pmotor->moves++;
+    sim_status(pmotor, target - pmotor->position);
+    pmotor->needUpdate = 1;
+}
+
+static CALLBACK_VALUE update_values(struct axisRecord *pmr)
+{
+    axisTestPvt *pPvt = (axisTestPvt *) pmr->dpvt;
+    axisTestMotor *pmotor = &pPvt->motor;
+    double readback;
+
+    if (!pmotor->needUpdate)
+        return NOTHING_DONE;
+    pmotor->needUpdate = 0;
+    pmotor->updates++;
+    readback = sim_readback(pmotor);
+    pmr->priv->readBack.position = readback;
+    pmr->priv->readBack.encoderPosition = readback;
+    pmr->rmp = (epicsInt32) floor(readback + 0.5);
+    pmr->rep = pmr->rmp;
+    pmr->msta = pmotor->status;
+    return CALLBACK_DATA;
+}
+
+static long start_trans(struct axisRecord *pmr)
+{
+    return OK;
+}
+
+static RTN_STATUS build_trans(motor_cmnd command, double *param,
+                              struct axisRecord *pmr)
+{
+    axisTestPvt *pPvt = (axisTestPvt *) pmr->dpvt;
+    axisTestMotor *pmotor = &pPvt->motor;
+
+    pmotor->commands++;
+    switch (command) {
+        case MOVE_ABS:
+        case MOVE_REL:
+            pmotor->moveCommand = command;
+            pmotor->moveParam = *param;
+            break;
+        case HOME_FOR:
+        case HOME_REV:
+            pmotor->moveCommand = MOVE_ABS;
+            pmotor->moveParam = 0.0;
+            break;
+        case GO:
+            sim_start(pmotor, pmotor->moveCommand == MOVE_REL ?
+                      pmotor->position + pmotor->moveParam : pmotor->moveParam);
+            break;
+        case SET_VELOCITY:
+            pmotor->velocity = fabs(*param);
+            break;
+        case JOG:
+        case JOG_VELOCITY:
+            pmotor->jogVelocity = *param;
+            pmotor->moving = (*param != 0.0);
+            pmotor->needUpdate = 1;
+            break;
+        case STOP_AXIS:
+            pmotor->stops++;
+            if (pmotor->moving)
+                sim_stop(pmotor);
+            sim_status(pmotor, 0.0);
+            pmotor->needUpdate = 1;
+            break;
+        case LOAD_POS:
+            pmotor->position = *param;
+            sim_status(pmotor, 0.0);
+            pmotor->needUpdate = 1;
+            break;
+        case GET_INFO:
+            pmotor->needUpdate = 1;
+            break;
+        case RETARGET:
+            if (!pmotor->retarget || !pmotor->moving || pmotor->jogVelocity != 0.0)
+                return ERROR;
+            pmotor->target = *param;
+            pmotor->retargets++;
+            pmotor->needUpdate = 1;
+            break;
+        case SET_BACKLASH:
+        case SET_RETRY:
+            /* The record does them */
+            return ERROR;
+        default:
+            break;
+    }
+    return OK;
+}
+
+static RTN_STATUS end_trans(struct axisRecord *pmr)
+{
+    return OK;
+}
+
+/*****************************************************************************
+  The records
+*****************************************************************************/
+axisRecord *axisTestCreate(const char *name)
+{
+    axisRecord *pmr = (axisRecord *) callocMustSucceed(1, sizeof(axisRecord),
+                                                       "axisTestCreate");
+    axisTestPvt *pPvt = (axisTestPvt *) callocMustSucceed(1, sizeof(axisTestPvt),
+                                                          "axisTestCreate");
+
+    strncpy(pmr->name, name, sizeof(pmr->name) - 1);
+    pmr->dset = (struct dset *) &axisTestDset;
+    pmr->dpvt = pPvt;
+    pmr->disv = 1;
+
+    /* initial() of axisRecord.dbd */
+    pmr->accl = 0.2;
+    pmr->bacc = 0.5;
+    pmr->frac = 1.0;
+    pmr->srev = 200;
+    pmr->rtry = 10;
+    pmr->spmg = pmr->lspg = motorSPMG_Go;
+    pmr->dmov = 1;
+    pmr->lvio = 1;
+    pmr->stup = motorSTUP_OFF;
+    pmr->rmod = motorRMOD_D;
+
+    pmr->mres = 0.01;
+    pmr->velo = 1.0;
+    pmr->vbas = 0.1;
+    pmr->bvel = 1.0;
+    pmr->jvel = 1.0;
+    pmr->hvel = 1.0;
+    pmr->rdbd = 0.02;
+
+    pPvt->pmr = pmr;
+    pPvt->motor.velocity = 100.0;
+    pPvt->motor.needUpdate = 1;
+    sim_status(&pPvt->motor, 0.0);
+    ellAdd(&testList, &pPvt->node);
+    return pmr;
+}
+
+/* init_record() of axisRecord.cc */
+long axisTestInit(axisRecord *pmr)
+{
+    axisEngine *pengine = new axisEngine(pmr);
+
+    pmr->cbak = (void *) pengine;
+    pengine->init();
+    if (pmr->dol.type == CONSTANT)
+        pmr->udf = FALSE;
+    return pengine->initialPoll();
+}
+
+axisTestMotor *axisTestGetMotor(axisRecord *pmr)
+{
+    return &((axisTestPvt *) pmr->dpvt)->motor;
+}
+
+long axisTestProcess(axisRecord *pmr)
+{
+    axisTestCount.processes++;
+    return ((axisEngine *) pmr->cbak)->process();
+}
+
+double axisTestTime(void)
+{
+    return testTime;
+}
+
+void axisTestRun(double seconds)
+{
+    double end = testTime + seconds - axisTestTick / 2;
+    axisTestPvt *pPvt;
+    int i;
+
+    while (testTime < end)
+    {
+        testTime += axisTestTick;
+        for (pPvt = (axisTestPvt *) ellFirst(&testList); pPvt;
+             pPvt = (axisTestPvt *) ellNext(&pPvt->node))
+        {
+            axisRecord *pmr = pPvt->pmr;
+
+            sim_step(&pPvt->motor, axisTestTick);
+            for (i = 0; i < TEST_TIMERS; i++)
+            {
+                CALLBACK *pcallback = pPvt->timers[i].pcallback;
+
+                if (pcallback && pPvt->timers[i].due <= testTime + 1e-9)
+                {
+                    pPvt->timers[i].pcallback = NULL;
+                    (*pcallback->callback)(pcallback);
+                }
+            }
+            /* The status callback */
+            if (pPvt->motor.needUpdate)
+                axisTestProcess(pmr);
+            /* The scanOnce() task */
+            while (pPvt->scanQueued)
+            {
+                pPvt->scanQueued = 0;
+                axisTestProcess(pmr);
+            }
+        }
+    }
+}
+
+int axisTestWaitDone(axisRecord *pmr, double timeout)
+{
+    double end = testTime + timeout;
+
+    do {
+        axisTestRun(axisTestTick);
+    } while (!pmr->dmov && testTime < end);
+    return pmr->dmov;
+}
@@ -0,0 +1,98 @@
+/*
+ * axisTestSim.h
+ *
+ * A simulated IOC and a simulated motor to run axisEngine, the motion logic
+ * of the axis record, without an IOC.  Used by axisEngineTest and
+ * axisEngineBench.
+ *
+ * The IOC is an implementation of axisRecIoc.h.  It has a simulated clock,
+ * the timers of recIocRequestDelay() and the queue of recIocScanOnce() run
+ * on it.  Monitors and forward links are only counted.
+ *
+ * The motor is device support for the record.  It moves with a constant
+ * velocity, without acceleration, and stops at once.  Every tick of
+ * axisTestRun() moves the motors and processes the records of those that
+ * have a new status, like the status callback of devAxisAsyn does.
+ */
+
+#ifndef INC_axisTestSim_H
+#define INC_axisTestSim_H
+
+#include <epicsTypes.h>
+#include "axisRecord.h"
+#include "axis.h"
+#include "axisEngine.h"
+
+typedef struct {
+    /* Settings, raw units */
+    double velocity;        /* SET_VELOCITY */
+    double highLimit;       /* Limit switches, off while highLimit <= lowLimit */
+    double lowLimit;
+    int retarget;           /* RETARGET is supported */
+    double miss;            /* The next moves end this many steps short */
+    int misses;             /* of the target, for this many moves */
+    double ring;            /* After a move the readback rings with this */
+    int ringTicks;          /* amplitude, for this many ticks */
+
+    /* State */
+    double position;
+    double target;
+    double jogVelocity;     /* 0 unless jogging */
+    int moving;
+    int ringLeft;
+    motor_cmnd moveCommand; /* Of the transaction, started by GO */
+    double moveParam;
+    int needUpdate;         /* A status for the record */
+    epicsUInt32 status;
+
+    /* Counters */
+    unsigned long commands;
+    unsigned long moves;
+    unsigned long retargets;
+    unsigned long stops;
+    unsigned long updates;
+} axisTestMotor;
+
+typedef struct {
+    unsigned long processes;
+    unsigned long posts;
+    unsigned long fwdLinks;
+} axisTestCounters;
+
+extern axisTestCounters axisTestCount;
+
+/* A record with the defaults of axisRecord.dbd, no soft limits and a
+   resolution of 0.01.  Change the fields before axisTestInit(). */
+axisRecord *axisTestCreate(const char *name);
+long axisTestInit(axisRecord *pmr);
+axisTestMotor *axisTestGetMotor(axisRecord *pmr);
+
+/* dbProcess() */
+long axisTestProcess(axisRecord *pmr);
+
+/* dbPutField() of a field that processes the record */
+template <class T>
+long axisTestPut(axisRecord *pmr, int fieldIndex, T *pfield, T value)
+{
+    axisEngine *pengine = (axisEngine *) pmr->cbak;
+    long status;
+
+    status = pengine->special(fieldIndex, 0);
+    if (status)
+        return status;
+    *pfield = value;
+    status = pengine->special(fieldIndex, 1);
+    if (status)
+        return status;
+    return axisTestProcess(pmr);
+}
+
+/* Run the simulation for the given time, in ticks of axisTestTick seconds */
+extern double axisTestTick;
+void axisTestRun(double seconds);
+/* Run until DMOV is true, at most timeout seconds. Returns DMOV. */
+int axisTestWaitDone(axisRecord *pmr, double timeout);
+/* Seconds since the start of the simulation */
+double axisTestTime(void);
+
+#endif /* INC_axisTestSim_H */
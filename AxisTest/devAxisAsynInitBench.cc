@@ -0,0 +1,186 @@
+/*
+ * devAxisAsynInitBench.cc
+ *
+ * Time of iocInit for axis records with saved positions, on ports whose
+ * driver takes a fixed time for each position it sets, like a controller
+ * on a serial line.  devAxisAsyn restores the positions after
+ * init_record(), with one request per port, so iocInit doesn't wait for
+ * them and the ports restore in parallel.
+ *
+ * Usage: devAxisAsynInitBench [ports [axes [delay]]]
+ * delay is the time of one position set in seconds.  Run by hand, timings
+ * don't belong in runtests.
+ */
+
+#include <stdlib.h>
+
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <epicsStdio.h>
+#include <dbAccess.h>
+#include <dbUnitTest.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "asynAxisController.h"
+#include "asynAxisAxis.h"
+
+extern "C" int devAxisAsynTest_registerRecordDeviceDriver(struct dbBase *);
+
+class benchController;
+
+class benchAxis : public asynAxisAxis
+{
+public:
+    benchAxis(benchController *pC, int axis);
+    asynStatus setPosition(double position);
+    asynStatus poll(bool *moving);
+
+private:
+    benchController *pC_;
+    double position_;
+};
+
+class benchController : public asynAxisController
+{
+public:
+    benchController(const char *portName, int numAxes, double delay);
+    void shutdown();
+
+private:
+    double delay_;
+
+    friend class benchAxis;
+};
+
+benchAxis::benchAxis(benchController *pC, int axis)
+  : asynAxisAxis(pC, axis), pC_(pC), position_(0.0)
+{
+}
+
+/* The round trip to the controller, with the lock like a real driver */
+asynStatus benchAxis::setPosition(double position)
+{
+    epicsThreadSleep(pC_->delay_);
+    position_ = position;
+    setDoubleParam(pC_->motorPosition_, position);
+    setDoubleParam(pC_->motorEncoderPosition_, position);
+    return asynSuccess;
+}
+
+asynStatus benchAxis::poll(bool *moving)
+{
+    setDoubleParam(pC_->motorPosition_, position_);
+    setDoubleParam(pC_->motorEncoderPosition_, position_);
+    setIntegerParam(pC_->motorStatusDone_, 1);
+    setIntegerParam(pC_->motorStatusMoving_, 0);
+    callParamCallbacks();
+    *moving = false;
+    return asynSuccess;
+}
+
+benchController::benchController(const char *portName, int numAxes, double delay)
+  : asynAxisController(portName, numAxes, 0, 0, 0,
+                       ASYN_CANBLOCK | ASYN_MULTIDEVICE, 1, 0, 0),
+    delay_(delay)
+{
+    int axis;
+
+    for (axis = 0; axis < numAxes; axis++)
+        new benchAxis(this, axis);
+    startPoller(0.1, 0.1, 0);
+}
+
+void benchController::shutdown()
+{
+    lock();
+    shuttingDown_ = 1;
+    unlock();
+    wakeupPoller();
+}
+
+static double getDouble(const char *pv)
+{
+    DBADDR addr;
+    double value = 0.0;
+
+    if (dbNameToAddr(pv, &addr) ||
+        dbGetField(&addr, DBR_DOUBLE, &value, NULL, NULL, NULL))
+        testAbort("can't read %s", pv);
+    return value;
+}
+
+/* Number of records whose RRBV is at the saved position */
+static int countRestored(int ports, int axes)
+{
+    char pv[64];
+    int port, axis, restored = 0;
+
+    for (port = 0; port < ports; port++)
+        for (axis = 0; axis < axes; axis++)
+        {
+            epicsSnprintf(pv, sizeof(pv), "P%d:axis%d.RRBV", port, axis);
+            if (getDouble(pv) == 10.0 + axis)
+                restored++;
+        }
+    return restored;
+}
+
+MAIN(devAxisAsynInitBench)
+{
+    int ports = (argc > 1) ? atoi(argv[1]) : 4;
+    int axes = (argc > 2) ? atoi(argv[2]) : 50;
+    double delay = (argc > 3) ? atof(argv[3]) : 0.005;
+    benchController **pControllers;
+    char portName[32], prefix[32], addr[16], subs[128];
+    epicsTimeStamp start, inited, restored;
+    int port, axis, count;
+
+    testPlan(1);
+    testdbPrepare();
+    testdbReadDatabase("devAxisAsynTest.dbd", NULL, NULL);
+    devAxisAsynTest_registerRecordDeviceDriver(pdbbase);
+
+    pControllers = new benchController *[ports];
+    for (port = 0; port < ports; port++)
+    {
+        epicsSnprintf(portName, sizeof(portName), "BENCH%d", port);
+        epicsSnprintf(prefix, sizeof(prefix), "P%d:", port);
+        pControllers[port] = new benchController(portName, axes, delay);
+        for (axis = 0; axis < axes; axis++)
+        {
+            epicsSnprintf(addr, sizeof(addr), "%d", axis);
+            epicsSnprintf(subs, sizeof(subs), "P=%s,PORT=%s,ADDR=%s,DVAL=%d",
+                          prefix, portName, addr, 10 + axis);
+            testdbReadDatabase("devAxisAsynInitBench.db", NULL, subs);
+        }
+    }
+
+    epicsTimeGetCurrent(&start);
+    testIocInitOk();
+    epicsTimeGetCurrent(&inited);
+    do
+    {
+        epicsThreadSleep(0.001);
+        count = countRestored(ports, axes);
+        epicsTimeGetCurrent(&restored);
+    } while (count < ports * axes &&
+             epicsTimeDiffInSeconds(&restored, &start) < 60.0 +
+                 ports * axes * delay);
+
+    testOk(count == ports * axes, "%d of %d positions restored",
+           count, ports * axes);
+    testDiag("%d ports, %d axes each, %g s per position set", ports, axes, delay);
+    testDiag("iocInit                     %.3f s",
+             epicsTimeDiffInSeconds(&inited, &start));
+    testDiag("positions restored after    %.3f s",
+             epicsTimeDiffInSeconds(&restored, &start));
+    testDiag("one port restores its axes  %.3f s", axes * delay);
+    testDiag("one position at a time      %.3f s", ports * axes * delay);
+
+    for (port = 0; port < ports; port++)
+        pControllers[port]->shutdown();
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}
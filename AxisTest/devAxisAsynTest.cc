@@ -0,0 +1,366 @@
+/*
+ * devAxisAsynTest.cc
+ *
+ * Tests of devAxisAsyn in a test IOC, with axis records on the axes of a
+ * driver that only logs the commands.  Moves are instant, a move can be
+ * held in the port thread until the test opens the gate.  axis2 has a
+ * saved position, which devAxisAsyn restores after init_record().
+ */
+
+#include <string.h>
+
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsStdio.h>
+#include <dbAccess.h>
+#include <dbUnitTest.h>
+#include <epicsUnitTest.h>
+#include <testMain.h>
+
+#include "asynAxisController.h"
+#include "asynAxisAxis.h"
+
+#define TEST_PORT   "AXISTEST"
+#define TEST_NAXES  3
+#define TEST_LOGLEN 256
+
+extern "C" int devAxisAsynTest_registerRecordDeviceDriver(struct dbBase *);
+
+class axisTestController;
+
+class axisTestAxis : public asynAxisAxis
+{
+public:
+    axisTestAxis(axisTestController *pC, int axis);
+    asynStatus move(double position, int relative, double minVelocity,
+                    double maxVelocity, double acceleration);
+    asynStatus stop(double acceleration);
+    asynStatus setPosition(double position);
+    asynStatus poll(bool *moving);
+
+private:
+    axisTestController *pC_;
+    double position_;
+
+    friend class axisTestController;
+};
+
+class axisTestController : public asynAxisController
+{
+public:
+    axisTestController();
+    void publish(int axis, double position);
+    void closeGate();
+    int waitEntered(double timeout);
+    void openGate();
+    void getLog(char *log, size_t size);
+    void clearLog();
+    void shutdown();
+
+private:
+    void log(char command, int axis);
+
+    epicsEventId gate_;
+    epicsEventId entered_;
+    int gateClosed_;
+    char log_[TEST_LOGLEN];
+
+    friend class axisTestAxis;
+};
+
+axisTestAxis::axisTestAxis(axisTestController *pC, int axis)
+  : asynAxisAxis(pC, axis), pC_(pC), position_(0.0)
+{
+}
+
+/* Called with the lock, in the port thread */
+asynStatus axisTestAxis::move(double position, int relative, double minVelocity,
+                              double maxVelocity, double acceleration)
+{
+    pC_->log('M', axisNo_);
+    if (pC_->gateClosed_)
+    {
+        epicsEventSignal(pC_->entered_);
+        pC_->unlock();
+        epicsEventMustWait(pC_->gate_);
+        pC_->lock();
+    }
+    position_ = relative ? position_ + position : position;
+    return asynSuccess;
+}
+
+asynStatus axisTestAxis::stop(double acceleration)
+{
+    pC_->log('S', axisNo_);
+    return asynSuccess;
+}
+
+asynStatus axisTestAxis::setPosition(double position)
+{
+    pC_->log('P', axisNo_);
+    position_ = position;
+    setDoubleParam(pC_->motorPosition_, position);
+    setDoubleParam(pC_->motorEncoderPosition_, position);
+    return asynSuccess;
+}
+
+asynStatus axisTestAxis::poll(bool *moving)
+{
+    setDoubleParam(pC_->motorPosition_, position_);
+    setDoubleParam(pC_->motorEncoderPosition_, position_);
+    setIntegerParam(pC_->motorStatusDone_, 1);
+    setIntegerParam(pC_->motorStatusMoving_, 0);
+    callParamCallbacks();
+    *moving = false;
+    return asynSuccess;
+}
+
+axisTestController::axisTestController()
+  : asynAxisController(TEST_PORT, TEST_NAXES, 0, 0, 0,
+                       ASYN_CANBLOCK | ASYN_MULTIDEVICE, 1, 0, 0),
+    gateClosed_(0)
+{
+    int axis;
+
+    gate_ = epicsEventMustCreate(epicsEventEmpty);
+    entered_ = epicsEventMustCreate(epicsEventEmpty);
+    log_[0] = '\0';
+    for (axis = 0; axis < TEST_NAXES; axis++)
+        new axisTestAxis(this, axis);
+    startPoller(0.05, 0.1, 2);
+}
+
+/* A status from the controller, as a poll would give it */
+void axisTestController::publish(int axis, double position)
+{
+    axisTestAxis *pAxis = (axisTestAxis *) getAxis(axis);
+
+    lock();
+    pAxis->position_ = position;
+    pAxis->setDoubleParam(motorPosition_, position);
+    pAxis->setDoubleParam(motorEncoderPosition_, position);
+    pAxis->callParamCallbacks();
+    unlock();
+}
+
+/* The next move waits in the port thread until openGate() */
+void axisTestController::closeGate()
+{
+    lock();
+    gateClosed_ = 1;
+    unlock();
+}
+
+int axisTestController::waitEntered(double timeout)
+{
+    return epicsEventWaitWithTimeout(entered_, timeout) == epicsEventWaitOK;
+}
+
+void axisTestController::openGate()
+{
+    lock();
+    gateClosed_ = 0;
+    unlock();
+    epicsEventSignal(gate_);
+}
+
+void axisTestController::log(char command, int axis)
+{
+    size_t len = strlen(log_);
+
+    if (len + 4 < sizeof(log_))
+        epicsSnprintf(log_ + len, sizeof(log_) - len, "%c%d,", command, axis);
+}
+
+void axisTestController::getLog(char *log, size_t size)
+{
+    lock();
+    strncpy(log, log_, size - 1);
+    log[size - 1] = '\0';
+    unlock();
+}
+
+void axisTestController::clearLog()
+{
+    lock();
+    log_[0] = '\0';
+    unlock();
+}
+
+void axisTestController::shutdown()
+{
+    lock();
+    shuttingDown_ = 1;
+    unlock();
+    wakeupPoller();
+}
+
+static axisTestController *pController;
+
+static double getDouble(const char *pv)
+{
+    DBADDR addr;
+    double value = 0.0;
+
+    if (dbNameToAddr(pv, &addr) ||
+        dbGetField(&addr, DBR_DOUBLE, &value, NULL, NULL, NULL))
+        testAbort("can't read %s", pv);
+    return value;
+}
+
+/* Wait until pv has value */
+static int waitFor(const char *pv, double value, double timeout)
+{
+    for (; timeout > 0.0; timeout -= 0.01)
+    {
+        if (getDouble(pv) == value)
+            return 1;
+        epicsThreadSleep(0.01);
+    }
+    return getDouble(pv) == value;
+}
+
+/* Wait until pv changes from value */
+static int waitChange(const char *pv, double value, double timeout)
+{
+    for (; timeout > 0.0; timeout -= 0.01)
+    {
+        if (getDouble(pv) != value)
+            return 1;
+        epicsThreadSleep(0.01);
+    }
+    return getDouble(pv) != value;
+}
+
+static void testRestore(void)
+{
+    char log[TEST_LOGLEN];
+    int done;
+
+    testDiag("Saved position restored after init_record()");
+    testOk(getDouble("axis2.VAL") == 25.0, "VAL %g, the saved position",
+           getDouble("axis2.VAL"));
+    done = waitFor("axis2.RRBV", 25.0, 5.0);
+    testOk(done, "RRBV %g at the saved position", getDouble("axis2.RRBV"));
+    pController->getLog(log, sizeof(log));
+    testOk(strcmp(log, "P2,") == 0, "commands %s", log);
+}
+
+static void testMerge(void)
+{
+    dbCommon *prec = testdbRecordPtr("axis0");
+    double count;
+    int i, done;
+
+    testDiag("Statuses merged while the record is busy");
+    count = getDouble("count0");
+    dbScanLock(prec);
+    for (i = 1; i <= 10; i++)
+        pController->publish(0, 100.0 + i);
+    epicsThreadSleep(0.2);
+    testOk(getDouble("count0") == count, "no pass while the record is locked");
+    dbScanUnlock(prec);
+    done = waitFor("axis0.RRBV", 110.0, 2.0);
+    testOk(done, "RRBV %g, the last status", getDouble("axis0.RRBV"));
+    epicsThreadSleep(0.2);
+    testOk(getDouble("count0") == count + 1, "%g pass for 10 statuses",
+           getDouble("count0") - count);
+}
+
+static void testPending(void)
+{
+    double count;
+    int entered, done;
+
+    testDiag("Statuses while a move is pending");
+    pController->closeGate();
+    testdbPutFieldOk("axis0.VAL", DBR_DOUBLE, 200.0);
+    entered = pController->waitEntered(5.0);
+    testOk(entered, "move held in the port thread");
+    if (!entered)
+        testAbort("no move");
+    count = getDouble("count0");
+    pController->publish(0, 120.0);
+    pController->publish(0, 130.0);
+    epicsThreadSleep(0.2);
+    testOk(getDouble("count0") == count, "no pass for a status before the move");
+    testOk(getDouble("axis0.RRBV") == 110.0, "RRBV %g not from those statuses",
+           getDouble("axis0.RRBV"));
+    pController->openGate();
+    done = waitFor("axis0.DMOV", 1.0, 5.0);
+    testOk(done && getDouble("axis0.RRBV") == 200.0, "move done, RRBV %g at VAL",
+           getDouble("axis0.RRBV"));
+    testOk(waitChange("count0", count, 1.0), "passes after the move");
+}
+
+/* Hold a move of axis0 in the port thread, behind it the commands that
+   the test queues */
+static void holdMove(double value)
+{
+    pController->closeGate();
+    pController->clearLog();
+    testdbPutFieldOk("axis0.VAL", DBR_DOUBLE, value);
+    if (!pController->waitEntered(5.0))
+        testAbort("no move");
+}
+
+static void testStopPriority(void)
+{
+    char log[TEST_LOGLEN];
+    int done;
+
+    testDiag("A stop overtakes the moves in the queue");
+    holdMove(300.0);
+    testdbPutFieldOk("axis1.VAL", DBR_DOUBLE, 50.0);
+    testdbPutFieldOk("axis0.STOP", DBR_SHORT, 1);
+    pController->openGate();
+    done = waitFor("axis0.DMOV", 1.0, 5.0) && waitFor("axis1.DMOV", 1.0, 5.0);
+    pController->getLog(log, sizeof(log));
+    testOk(done && strcmp(log, "M0,S0,M1,") == 0, "commands %s", log);
+    testOk(getDouble("axis1.RRBV") == 50.0, "axis1 RRBV %g at VAL",
+           getDouble("axis1.RRBV"));
+}
+
+static void testStopDrop(void)
+{
+    char log[TEST_LOGLEN];
+    int done;
+
+    testDiag("A stop drops the queued move of its axis");
+    holdMove(400.0);
+    testdbPutFieldOk("axis1.VAL", DBR_DOUBLE, 80.0);
+    testdbPutFieldOk("axis1.STOP", DBR_SHORT, 1);
+    pController->openGate();
+    done = waitFor("axis0.DMOV", 1.0, 5.0) && waitFor("axis1.DMOV", 1.0, 5.0);
+    pController->getLog(log, sizeof(log));
+    testOk(done && strcmp(log, "M0,S1,") == 0, "commands %s", log);
+    testOk(getDouble("axis1.RRBV") == 50.0, "axis1 RRBV %g, not moved",
+           getDouble("axis1.RRBV"));
+    testOk(getDouble("axis0.RRBV") == 400.0, "axis0 RRBV %g at VAL",
+           getDouble("axis0.RRBV"));
+}
+
+MAIN(devAxisAsynTest)
+{
+    testPlan(24);
+
+    testdbPrepare();
+    testdbReadDatabase("devAxisAsynTest.dbd", NULL, NULL);
+    devAxisAsynTest_registerRecordDeviceDriver(pdbbase);
+    testdbReadDatabase("devAxisAsynTest.db", NULL, NULL);
+    pController = new axisTestController();
+    testIocInitOk();
+    testOk(waitFor("axis0.DMOV", 1.0, 5.0) && waitFor("axis1.DMOV", 1.0, 5.0),
+           "axes done after the initial poll");
+
+    testRestore();
+    testMerge();
+    testPending();
+    testStopPriority();
+    testStopDrop();
+
+    pController->shutdown();
+    testIocShutdownOk();
+    testdbCleanup();
+    return testDone();
+}